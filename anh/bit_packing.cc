@@ -0,0 +1,174 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/bit_packing.h"
+
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+namespace {
+
+uint64_t lowBitMask(unsigned bits) {
+    return (uint64_t(1) << bits) - 1;
+}
+
+// The largest quantized value, every step of the range is 1 / steps wide.
+double quantizationSteps(unsigned bits) {
+    return static_cast<double>(lowBitMask(bits));
+}
+
+}  // namespace
+
+BitWriter::BitWriter(ByteBuffer& buffer)
+    : buffer_(buffer)
+    , scratch_(0)
+    , scratch_bits_(0)
+    , bit_count_(0) {}
+
+BitWriter::~BitWriter() {
+    flush();
+}
+
+void BitWriter::write(uint32_t value, unsigned bits) {
+    assert(bits >= 1 && bits <= 32 && "Bit width must be between 1 and 32");
+
+    scratch_ |= (value & lowBitMask(bits)) << scratch_bits_;
+    scratch_bits_ += bits;
+    bit_count_ += bits;
+
+    // Hand whole words to the buffer, the accumulator always keeps room for
+    // another 32 bits.
+    if (scratch_bits_ >= 32) {
+        LittleEndianWriter(buffer_).write<uint32_t>(static_cast<uint32_t>(scratch_));
+
+        scratch_ >>= 32;
+        scratch_bits_ -= 32;
+    }
+}
+
+void BitWriter::writeBool(bool value) {
+    write(value ? 1 : 0, 1);
+}
+
+void BitWriter::writeQuantized(float value, float min, float max, unsigned bits) {
+    // The negated test also clamps NaN to the bottom of the range.
+    if (!(value > min)) {
+        value = min;
+    } else if (value > max) {
+        value = max;
+    }
+
+    double normalized = (static_cast<double>(value) - min) / (static_cast<double>(max) - min);
+    write(static_cast<uint32_t>(normalized * quantizationSteps(bits) + 0.5), bits);
+}
+
+void BitWriter::writeUnitVector(float x, float y, float z, unsigned bits) {
+    writeQuantized(x, -1.0f, 1.0f, bits);
+    writeQuantized(y, -1.0f, 1.0f, bits);
+    writeBool(z < 0.0f);
+}
+
+void BitWriter::flush() {
+    if (scratch_bits_ == 0) {
+        return;
+    }
+
+    unsigned char bytes[sizeof(uint32_t)];
+    size_t count = (scratch_bits_ + 7) / 8;
+
+    for (size_t i = 0; i < count; ++i) {
+        bytes[i] = static_cast<unsigned char>(scratch_ >> (i * 8));
+    }
+
+    buffer_.write(bytes, count);
+
+    scratch_ = 0;
+    scratch_bits_ = 0;
+}
+
+uint64_t BitWriter::bit_count() const {
+    return bit_count_;
+}
+
+BitReader::BitReader(ByteBuffer& buffer)
+    : buffer_(buffer)
+    , scratch_(0)
+    , scratch_bits_(0) {}
+
+BitReader::~BitReader() {
+    finish();
+}
+
+uint32_t BitReader::read(unsigned bits) {
+    assert(bits >= 1 && bits <= 32 && "Bit width must be between 1 and 32");
+
+    if (scratch_bits_ < bits) {
+        refill();
+
+        if (scratch_bits_ < bits) {
+            throw std::out_of_range("Read past end of buffer");
+        }
+    }
+
+    uint32_t value = static_cast<uint32_t>(scratch_ & lowBitMask(bits));
+
+    scratch_ >>= bits;
+    scratch_bits_ -= bits;
+
+    return value;
+}
+
+bool BitReader::readBool() {
+    return read(1) != 0;
+}
+
+float BitReader::readQuantized(float min, float max, unsigned bits) {
+    double normalized = read(bits) / quantizationSteps(bits);
+    return static_cast<float>(min + normalized * (static_cast<double>(max) - min));
+}
+
+void BitReader::readUnitVector(float& x, float& y, float& z, unsigned bits) {
+    x = readQuantized(-1.0f, 1.0f, bits);
+    y = readQuantized(-1.0f, 1.0f, bits);
+
+    float z_squared = 1.0f - x * x - y * y;
+    z = (z_squared > 0.0f) ? std::sqrt(z_squared) : 0.0f;
+
+    if (readBool()) {
+        z = -z;
+    }
+}
+
+void BitReader::finish() {
+    // Whole bytes still in the accumulator were read ahead, the partial one
+    // belongs to the values already read.
+    buffer_.readPosition(buffer_.readPosition() - scratch_bits_ / 8);
+
+    scratch_ = 0;
+    scratch_bits_ = 0;
+}
+
+void BitReader::refill() {
+    size_t available = buffer_.size() - buffer_.readPosition();
+
+    // Only called with fewer than 32 bits left, so a whole word always fits.
+    if (available >= sizeof(uint32_t)) {
+        scratch_ |= uint64_t(LittleEndianReader(buffer_).read<uint32_t>()) << scratch_bits_;
+        scratch_bits_ += 32;
+        return;
+    }
+
+    // Near the end of the buffer take what is left a byte at a time.
+    while (available--) {
+        scratch_ |= uint64_t(buffer_.read<uint8_t>()) << scratch_bits_;
+        scratch_bits_ += 8;
+    }
+}
+
+}  // namespace anh
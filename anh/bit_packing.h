@@ -0,0 +1,131 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#ifndef ANH_BIT_PACKING_H_
+#define ANH_BIT_PACKING_H_
+
+#include <cstdint>
+
+#include "anh/byte_buffer.h"
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+/*! \brief Packs values of arbitrary bit widths into a ByteBuffer.
+ *
+ * Bits are collected in a 64-bit accumulator and reach the buffer a 32-bit
+ * little endian word at a time, least significant bit first. The last partial
+ * byte is written by flush, which the destructor calls, after which the
+ * buffer is byte aligned again.
+ *
+ * \code
+ * {
+ *     anh::BitWriter bits(buffer);
+ *     bits.writeBool(moving);
+ *     bits.write(heading, 9);
+ *     bits.writeQuantized(position_x, -8192.0f, 8192.0f, 20);
+ * }
+ * \endcode
+ */
+class BitWriter {
+public:
+    explicit BitWriter(ByteBuffer& buffer);
+
+    /// Flushes any bits still held in the accumulator.
+    ~BitWriter();
+
+    /**
+     * Writes the low bits of a value.
+     *
+     * \param value The value to write, bits above the width are ignored.
+     * \param bits The number of bits to write, 1 to 32.
+     */
+    void write(uint32_t value, unsigned bits);
+
+    void writeBool(bool value);
+
+    /**
+     * Writes a float in a known range as an evenly spaced fixed point value.
+     * Values outside the range are clamped.
+     *
+     * \param value The value to write.
+     * \param min The smallest value of the range.
+     * \param max The largest value of the range.
+     * \param bits The number of bits to use, 1 to 32.
+     */
+    void writeQuantized(float value, float min, float max, unsigned bits);
+
+    /**
+     * Writes a unit length vector as its quantized x and y components and the
+     * sign of z, which is recovered from the other two when read.
+     *
+     * \param bits The number of bits used for each of x and y.
+     */
+    void writeUnitVector(float x, float y, float z, unsigned bits);
+
+    /// Writes the last partial byte, padding it with zero bits.
+    void flush();
+
+    /// \returns The number of bits written so far.
+    uint64_t bit_count() const;
+
+private:
+    /// Disable copying, the accumulator belongs to a single writer.
+    BitWriter(const BitWriter&);
+    BitWriter& operator=(const BitWriter&);
+
+    ByteBuffer& buffer_;
+    uint64_t scratch_;
+    unsigned scratch_bits_;
+    uint64_t bit_count_;
+};
+
+/*! \brief Reads values written by BitWriter from a ByteBuffer.
+ *
+ * The buffer is read a 32-bit word at a time. On destruction, or when finish
+ * is called, bytes read ahead but not used are given back so the buffer's read
+ * position sits just after the last byte that held a bit that was read.
+ */
+class BitReader {
+public:
+    explicit BitReader(ByteBuffer& buffer);
+
+    /// Gives back any bytes that were read ahead.
+    ~BitReader();
+
+    /**
+     * Reads a value of the given width.
+     *
+     * \param bits The number of bits to read, 1 to 32.
+     * \throws std::out_of_range If the read runs past the end of the buffer.
+     */
+    uint32_t read(unsigned bits);
+
+    bool readBool();
+
+    /// Reads a float written by BitWriter::writeQuantized with the same arguments.
+    float readQuantized(float min, float max, unsigned bits);
+
+    /// Reads a vector written by BitWriter::writeUnitVector with the same width.
+    void readUnitVector(float& x, float& y, float& z, unsigned bits);
+
+    /// Skips the rest of the current byte and gives back bytes read ahead.
+    void finish();
+
+private:
+    /// Disable copying, the accumulator belongs to a single reader.
+    BitReader(const BitReader&);
+    BitReader& operator=(const BitReader&);
+
+    void refill();
+
+    ByteBuffer& buffer_;
+    uint64_t scratch_;
+    unsigned scratch_bits_;
+};
+
+}  // namespace anh
+
+#endif  // ANH_BIT_PACKING_H_
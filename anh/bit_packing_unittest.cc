@@ -0,0 +1,176 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/bit_packing.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <gtest/gtest.h>
+
+using anh::BitReader;
+using anh::BitWriter;
+using anh::ByteBuffer;
+
+// Wrapping tests in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+TEST(BitPackingTests, BoolsTakeOneBitEach)
+{
+    ByteBuffer buffer;
+    {
+        BitWriter bits(buffer);
+        for (int i = 0; i < 10; ++i) {
+            bits.writeBool(i % 3 == 0);
+        }
+        EXPECT_EQ(10u, bits.bit_count());
+    }
+
+    EXPECT_EQ(2u, buffer.size());
+
+    BitReader bits(buffer);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(i % 3 == 0, bits.readBool());
+    }
+}
+
+TEST(BitPackingTests, CanRoundTripEveryWidth)
+{
+    ByteBuffer buffer;
+    {
+        BitWriter bits(buffer);
+        for (unsigned width = 1; width <= 32; ++width) {
+            bits.write(0xFFFFFFFF >> (32 - width), width);
+            bits.write(0x5A5A5A5A, width);
+        }
+    }
+
+    // Every width is written twice: 2 * (1 + 2 + ... + 32) bits.
+    EXPECT_EQ(size_t((2 * 528 + 7) / 8), buffer.size());
+
+    BitReader bits(buffer);
+    for (unsigned width = 1; width <= 32; ++width) {
+        uint32_t mask = 0xFFFFFFFF >> (32 - width);
+        EXPECT_EQ(mask, bits.read(width)) << "width " << width;
+        EXPECT_EQ(0x5A5A5A5A & mask, bits.read(width)) << "width " << width;
+    }
+}
+
+TEST(BitPackingTests, BitsAboveTheWidthAreIgnored)
+{
+    ByteBuffer buffer;
+    {
+        BitWriter bits(buffer);
+        bits.write(0xFF, 3);
+        bits.write(0, 5);
+    }
+
+    ASSERT_EQ(1u, buffer.size());
+    EXPECT_EQ(0x07, buffer.data()[0]);
+}
+
+TEST(BitPackingTests, ReaderGivesBackBytesReadAhead)
+{
+    ByteBuffer buffer;
+    {
+        BitWriter bits(buffer);
+        bits.write(0x1FF, 9);
+    }
+    buffer.write<uint32_t>(0xDEADBEEF);
+
+    {
+        BitReader bits(buffer);
+        EXPECT_EQ(0x1FFu, bits.read(9));
+    }
+
+    EXPECT_EQ(2u, buffer.readPosition());
+    EXPECT_EQ(0xDEADBEEF, buffer.read<uint32_t>());
+}
+
+TEST(BitPackingTests, ReadingPastBufferEndThrowsException)
+{
+    ByteBuffer buffer;
+    {
+        BitWriter bits(buffer);
+        bits.write(1, 12);
+    }
+
+    BitReader bits(buffer);
+    EXPECT_EQ(1u, bits.read(12));
+    EXPECT_EQ(0u, bits.read(4));
+    EXPECT_THROW(bits.read(1), std::out_of_range);
+}
+
+TEST(BitPackingTests, QuantizedFloatsStayWithinOneStep)
+{
+    const float kMin = -100.0f;
+    const float kMax = 100.0f;
+    const unsigned kBits = 10;
+    const float kStep = (kMax - kMin) / 1023.0f;
+
+    const float values[] = { -100.0f, -37.25f, 0.0f, 12.5f, 99.9f, 100.0f, 250.0f, -250.0f };
+
+    ByteBuffer buffer;
+    {
+        BitWriter bits(buffer);
+        for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+            bits.writeQuantized(values[i], kMin, kMax, kBits);
+        }
+    }
+
+    EXPECT_EQ(size_t((8 * kBits + 7) / 8), buffer.size());
+
+    BitReader bits(buffer);
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+        float expected = std::max(kMin, std::min(kMax, values[i]));
+        EXPECT_NEAR(expected, bits.readQuantized(kMin, kMax, kBits), kStep / 2);
+    }
+}
+
+TEST(BitPackingTests, RangeEndsAreExact)
+{
+    ByteBuffer buffer;
+    {
+        BitWriter bits(buffer);
+        bits.writeQuantized(-8192.0f, -8192.0f, 8192.0f, 20);
+        bits.writeQuantized(8192.0f, -8192.0f, 8192.0f, 20);
+    }
+
+    BitReader bits(buffer);
+    EXPECT_EQ(-8192.0f, bits.readQuantized(-8192.0f, 8192.0f, 20));
+    EXPECT_EQ(8192.0f, bits.readQuantized(-8192.0f, 8192.0f, 20));
+}
+
+TEST(BitPackingTests, CanRoundTripUnitVectors)
+{
+    const float vectors[][3] = {
+        { 1.0f, 0.0f, 0.0f },
+        { 0.0f, 0.0f, -1.0f },
+        { 0.6f, -0.8f, 0.0f },
+        { 0.267261f, 0.534522f, -0.801784f },
+    };
+
+    ByteBuffer buffer;
+    {
+        BitWriter bits(buffer);
+        for (size_t i = 0; i < 4; ++i) {
+            bits.writeUnitVector(vectors[i][0], vectors[i][1], vectors[i][2], 12);
+        }
+    }
+
+    EXPECT_EQ(size_t((4 * 25 + 7) / 8), buffer.size());
+
+    BitReader bits(buffer);
+    for (size_t i = 0; i < 4; ++i) {
+        float x, y, z;
+        bits.readUnitVector(x, y, z, 12);
+
+        EXPECT_NEAR(vectors[i][0], x, 0.001f);
+        EXPECT_NEAR(vectors[i][1], y, 0.001f);
+        EXPECT_NEAR(vectors[i][2], z, 0.05f);
+        EXPECT_EQ(vectors[i][2] < 0.0f, z < 0.0f);
+    }
+}
+
+}  // namespace
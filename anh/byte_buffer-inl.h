@@ -5,6 +5,7 @@
 #ifndef ANH_BYTE_BUFFER_INL_H_
 #define ANH_BYTE_BUFFER_INL_H_
 
+#include <cassert>
 #include <string>
 
 /// The anh namespace hosts a number of useful utility classes intended
@@ -17,13 +18,8 @@ ByteBuffer& operator<<(ByteBuffer& buffer, const T& value);
 std::ostream& operator<<(std::ostream& message, const ByteBuffer& buffer);
 
 template<typename T>
-void ByteBuffer::swapEndian(T& data) const {
-  //data; /* Only template specializations of swapEndian should be used */
-}
-
-template<typename T>
-ByteBuffer& ByteBuffer::write(T data) {
-  write(reinterpret_cast<unsigned char*>(&data), sizeof(T));
+ByteBuffer& ByteBuffer::write(const T& data) {
+  write(reinterpret_cast<const unsigned char*>(&data), sizeof(T));
   return *this;
 }
 
@@ -51,12 +47,96 @@ const T ByteBuffer::peekAt(size_t offset, bool doSwapEndian) const {
     throw std::out_of_range("Read past end of buffer");
   }
 
-  T data = *reinterpret_cast<const T*>(&data_[offset]);
+  if (!doSwapEndian) {
+    return *reinterpret_cast<const T*>(&data_[offset]);
+  }
 
-  if (doSwapEndian)
-    swapEndian<T>(data);
+  // Swap the stored bytes before they become a T, see ByteSwapper.
+  typename std::aligned_storage<sizeof(T), alignof(T)>::type bytes;
+  std::memcpy(&bytes, &data_[offset], sizeof(T));
+  ByteSwapper<T>::swapBytes(reinterpret_cast<unsigned char*>(&bytes));
 
-  return data;
+  return *reinterpret_cast<const T*>(&bytes);
+}
+
+template<typename T>
+ByteBuffer& ByteBuffer::writeArray(const T* data, size_t count) {
+  static_assert(std::is_arithmetic<T>::value, "Only arrays of arithmetic types can be written");
+
+  write(reinterpret_cast<const unsigned char*>(data), count * sizeof(T));
+  return *this;
+}
+
+template<typename T>
+void ByteBuffer::readArray(T* data, size_t count, bool doSwapEndian) {
+  static_assert(std::is_arithmetic<T>::value, "Only arrays of arithmetic types can be read");
+
+  if (data_.size() < read_position_ || (data_.size() - read_position_) / sizeof(T) < count) {
+    throw std::out_of_range("Read past end of buffer");
+  }
+
+  if (count == 0) {
+    return;
+  }
+
+  std::memcpy(data, &data_[read_position_], count * sizeof(T));
+
+  if (doSwapEndian && sizeof(T) > 1) {
+    swapEndianArray(reinterpret_cast<unsigned char*>(data), sizeof(T), count);
+  }
+
+  read_position_ += count * sizeof(T);
+}
+
+template<typename T>
+ByteBuffer& ByteBuffer::writeVarint(T data) {
+  static_assert(std::is_integral<T>::value, "Only integral types can be written as varints");
+
+  if (std::is_signed<T>::value) {
+    // Zigzag maps 0, -1, 1, -2, ... onto 0, 1, 2, 3, ...
+    int64_t value = static_cast<int64_t>(data);
+    writeUnsignedVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+  } else {
+    writeUnsignedVarint(static_cast<uint64_t>(data));
+  }
+
+  return *this;
+}
+
+template<typename T>
+const T ByteBuffer::readVarint() {
+  size_t available = (data_.size() > read_position_) ? data_.size() - read_position_ : 0;
+  const unsigned char* source = available ? data_.data() + read_position_ : data_.data();
+  size_t length = 0;
+
+  // Narrow before moving the read position, so a value that doesn't fit is
+  // left unread and the caller can retry with a wider type.
+  T value = narrowVarint<T>(decodeUnsignedVarint(source, available, &length));
+  read_position_ += length;
+
+  return value;
+}
+
+template<typename T>
+T ByteBuffer::narrowVarint(uint64_t raw) {
+  static_assert(std::is_integral<T>::value, "Only integral types can be read as varints");
+
+  if (std::is_signed<T>::value) {
+    int64_t value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+
+    if (value < static_cast<int64_t>(std::numeric_limits<T>::min()) ||
+        value > static_cast<int64_t>(std::numeric_limits<T>::max())) {
+      throw std::overflow_error("Varint does not fit in the requested type");
+    }
+
+    return static_cast<T>(value);
+  }
+
+  if (raw > static_cast<uint64_t>(std::numeric_limits<T>::max())) {
+    throw std::overflow_error("Varint does not fit in the requested type");
+  }
+
+  return static_cast<T>(raw);
 }
 
 template<typename T>
@@ -65,52 +145,148 @@ ByteBuffer& operator<<(ByteBuffer& buffer, const T& value) {
   return buffer;
 }
 
+template<typename ByteOrder>
+ByteBufferWriter<ByteOrder>::ByteBufferWriter(ByteBuffer& buffer)
+  : buffer_(buffer) {}
+
+template<typename ByteOrder>
 template<typename T>
-void ByteBuffer::swapEndian16(T& data) const {
-  data = (data >> 8) | (data << 8);
+ByteBufferWriter<ByteOrder>& ByteBufferWriter<ByteOrder>::write(const T& data) {
+  static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value ||
+    std::is_same<T, std::string>::value || std::is_same<T, std::wstring>::value,
+    "Only arithmetic, enum and string types have a byte order");
+
+  writeValue(data);
+  return *this;
+}
+
+template<typename ByteOrder>
+template<typename T>
+ByteBufferWriter<ByteOrder>& ByteBufferWriter<ByteOrder>::writeAt(size_t offset, T data) {
+  static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+    "Only arithmetic and enum types have a byte order");
+
+  unsigned char* bytes = reinterpret_cast<unsigned char*>(&data);
+  ByteOrder::template convertBytes<T>(bytes);
+
+  buffer_.write(offset, bytes, sizeof(T));
+  return *this;
+}
+
+template<typename ByteOrder>
+template<typename T>
+void ByteBufferWriter<ByteOrder>::writeValue(T data) {
+  unsigned char* bytes = reinterpret_cast<unsigned char*>(&data);
+  ByteOrder::template convertBytes<T>(bytes);
+
+  buffer_.write(bytes, sizeof(T));
+}
+
+template<typename ByteOrder>
+void ByteBufferWriter<ByteOrder>::writeValue(const std::string& data) {
+  writeValue(static_cast<uint16_t>(data.length()));
+  buffer_.write(reinterpret_cast<const unsigned char*>(data.data()), data.length());
+}
+
+template<typename ByteOrder>
+void ByteBufferWriter<ByteOrder>::writeValue(const std::wstring& data) {
+  writeValue(static_cast<uint32_t>(data.length()));
+
+  // Each wchar_t travels as one UTF-16 unit, as in ByteBuffer::write.
+  for (size_t i = 0; i < data.length(); ++i) {
+    writeValue(static_cast<uint16_t>(data[i]));
+  }
+}
+
+template<typename ByteOrder>
+ByteBuffer& ByteBufferWriter<ByteOrder>::buffer() const {
+  return buffer_;
+}
+
+template<typename ByteOrder>
+ByteBufferReader<ByteOrder>::ByteBufferReader(ByteBuffer& buffer)
+  : buffer_(buffer) {}
+
+template<typename ByteOrder>
+template<typename T>
+const T ByteBufferReader<ByteOrder>::peek() const {
+  static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+    "Only arithmetic and enum types have a byte order");
+
+  return buffer_.peek<T>(ByteOrder::is_swapped);
 }
 
+template<typename ByteOrder>
 template<typename T>
-void ByteBuffer::swapEndian32(T& data) const {
-  data =  (data >> 24) |
-         ((data & 0x00FF0000) >> 8) |
-         ((data & 0x0000FF00) << 8) |
-          (data << 24);
+const T ByteBufferReader<ByteOrder>::peekAt(size_t offset) const {
+  static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+    "Only arithmetic and enum types have a byte order");
+
+  return buffer_.peekAt<T>(offset, ByteOrder::is_swapped);
+}
+
+template<typename ByteOrder>
+template<typename T>
+const T ByteBufferReader<ByteOrder>::read() {
+  static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value ||
+    std::is_same<T, std::string>::value || std::is_same<T, std::wstring>::value,
+    "Only arithmetic, enum and string types have a byte order");
+
+  return buffer_.read<T>(ByteOrder::is_swapped);
+}
+
+template<typename ByteOrder>
+ByteBuffer& ByteBufferReader<ByteOrder>::buffer() const {
+  return buffer_;
+}
+
+template<typename ByteOrder>
+BasicReadCursor<ByteOrder>::BasicReadCursor(ByteBuffer& buffer)
+  : buffer_(buffer)
+  , position_(buffer.data() + buffer.readPosition())
+  , region_end_(position_) {}
+
+template<typename ByteOrder>
+BasicReadCursor<ByteOrder>::~BasicReadCursor() {
+  buffer_.readPosition(position_ - buffer_.data());
 }
 
+template<typename ByteOrder>
+BasicReadCursor<ByteOrder>& BasicReadCursor<ByteOrder>::require(size_t length) {
+  size_t offset = position_ - buffer_.data();
+
+  if (buffer_.size() < offset || buffer_.size() - offset < length) {
+    throw std::out_of_range("Read past end of buffer");
+  }
+
+  region_end_ = position_ + length;
+  return *this;
+}
+
+template<typename ByteOrder>
 template<typename T>
-void ByteBuffer::swapEndian64(T& data) const {
-  data = (data  >> 56) |
+const T BasicReadCursor<ByteOrder>::get() {
+  static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+    "Only arithmetic and enum types can be read with a cursor");
 
-#ifdef _WIN32
-    ((data & 0x00FF000000000000) >> 40) |
-    ((data & 0x0000FF0000000000) >> 24) |
-    ((data & 0x000000FF00000000) >> 8)  |
-    ((data & 0x00000000FF000000) << 8)  |
-    ((data & 0x0000000000FF0000) << 24) |
-    ((data & 0x000000000000FF00) << 40) |
-#else
-    ((data & 0x00FF000000000000LLU) >> 40) |
-    ((data & 0x0000FF0000000000LLU) >> 24) |
-    ((data & 0x000000FF00000000LLU) >> 8)  |
-    ((data & 0x00000000FF000000LLU) << 8)  |
-    ((data & 0x0000000000FF0000LLU) << 24) |
-    ((data & 0x000000000000FF00LLU) << 40) |
-#endif
+  assert(position_ + sizeof(T) <= region_end_ && "Read outside of the required region");
 
-    (data  << 56);
+  typename std::aligned_storage<sizeof(T), alignof(T)>::type bytes;
+  std::memcpy(&bytes, position_, sizeof(T));
+  ByteOrder::template convertBytes<T>(reinterpret_cast<unsigned char*>(&bytes));
+  position_ += sizeof(T);
+
+  return *reinterpret_cast<const T*>(&bytes);
 }
 
-template<> void ByteBuffer::swapEndian(uint16_t& data) const;
-template<> void ByteBuffer::swapEndian(uint32_t& data) const;
-template<> void ByteBuffer::swapEndian(uint64_t& data) const;
-template<> void ByteBuffer::swapEndian(int16_t& data) const;
-template<> void ByteBuffer::swapEndian(int32_t& data) const;
-template<> void ByteBuffer::swapEndian(int64_t& data) const;
+template<typename ByteOrder>
+size_t BasicReadCursor<ByteOrder>::remaining() const {
+  return region_end_ - position_;
+}
 
-template<> ByteBuffer& ByteBuffer::write<std::string>(std::string data);
+template<> ByteBuffer& ByteBuffer::write<std::string>(const std::string& data);
 template<> const std::string ByteBuffer::read<std::string>(bool doSwapEndian);
-template<> ByteBuffer& ByteBuffer::write<std::wstring>(std::wstring data);
+template<> ByteBuffer& ByteBuffer::write<std::wstring>(const std::wstring& data);
 template<> const std::wstring ByteBuffer::read<std::wstring>(bool doSwapEndian);
 
 }  // namespace anh
@@ -5,13 +5,235 @@
 #include "anh/byte_buffer.h"
 
 #include <algorithm>
+#include <cwchar>
 #include <iomanip>
 #include <iostream>
+#include <utility>
+
+// On x86 with gcc the bulk byte swap picks an SSSE3 or AVX2 kernel at runtime,
+// everything else uses the portable scalar loop.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ANH_BYTE_BUFFER_SIMD_SWAP 1
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ANH_BYTE_BUFFER_SSE2 1
+#endif
 
 /// The anh namespace hosts a number of useful utility classes intended
 /// to be used and reused in domain specific classes.
 namespace anh {
 
+namespace {
+
+template<size_t Size>
+void swapElementsScalar(unsigned char* data, size_t length) {
+  typedef ByteSwapTraits<Size> Traits;
+
+  for (size_t i = 0; i < length; i += Size) {
+    typename Traits::type value;
+    std::memcpy(&value, data + i, Size);
+    value = Traits::swap(value);
+    std::memcpy(data + i, &value, Size);
+  }
+}
+
+// Reverses the bytes of each element in [data, data + length).
+void swapBlocksScalar(unsigned char* data, size_t element_size, size_t length) {
+  switch (element_size) {
+    case 2: swapElementsScalar<2>(data, length); return;
+    case 4: swapElementsScalar<4>(data, length); return;
+    case 8: swapElementsScalar<8>(data, length); return;
+  }
+
+  for (size_t i = 0; i < length; i += element_size) {
+    std::reverse(data + i, data + i + element_size);
+  }
+}
+
+// Wide strings travel as UTF-16 code units, one unit per wchar_t. Where wchar_t
+// is 32 bits the units are widened and narrowed eight at a time with SSE2.
+#if WCHAR_MAX > 0xFFFF
+
+void widenUtf16(const unsigned char* source, size_t count, wchar_t* dest, bool swap) {
+  size_t i = 0;
+
+#ifdef ANH_BYTE_BUFFER_SSE2
+  const __m128i zero = _mm_setzero_si128();
+
+  for (; i + 8 <= count; i += 8) {
+    __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+
+    if (swap) {
+      units = _mm_or_si128(_mm_slli_epi16(units, 8), _mm_srli_epi16(units, 8));
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_unpacklo_epi16(units, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 4), _mm_unpackhi_epi16(units, zero));
+  }
+#endif
+
+  for (; i < count; ++i) {
+    uint16_t unit;
+    std::memcpy(&unit, source + i * 2, 2);
+    dest[i] = static_cast<wchar_t>(swap ? ByteSwapTraits<2>::swap(unit) : unit);
+  }
+}
+
+void narrowToUtf16(const wchar_t* source, size_t count, unsigned char* dest) {
+  size_t i = 0;
+
+#ifdef ANH_BYTE_BUFFER_SSE2
+  for (; i + 8 <= count; i += 8) {
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+    __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 4));
+
+    // Sign extend the low 16 bits of each lane so the saturating pack
+    // truncates exactly like a static_cast<uint16_t>.
+    low = _mm_srai_epi32(_mm_slli_epi32(low, 16), 16);
+    high = _mm_srai_epi32(_mm_slli_epi32(high, 16), 16);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 2), _mm_packs_epi32(low, high));
+  }
+#endif
+
+  for (; i < count; ++i) {
+    uint16_t unit = static_cast<uint16_t>(source[i]);
+    std::memcpy(dest + i * 2, &unit, 2);
+  }
+}
+
+#else  // WCHAR_MAX > 0xFFFF
+
+void widenUtf16(const unsigned char* source, size_t count, wchar_t* dest, bool swap) {
+  std::memcpy(dest, source, count * 2);
+
+  if (swap) {
+    swapElementsScalar<2>(reinterpret_cast<unsigned char*>(dest), count * 2);
+  }
+}
+
+void narrowToUtf16(const wchar_t* source, size_t count, unsigned char* dest) {
+  std::memcpy(dest, source, count * 2);
+}
+
+#endif  // WCHAR_MAX > 0xFFFF
+
+#ifdef ANH_BYTE_BUFFER_SIMD_SWAP
+
+// pshufb masks that reverse each 2, 4 and 8 byte lane of a 16 byte block.
+const unsigned char kSwapMask16[16] = {1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14};
+const unsigned char kSwapMask32[16] = {3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12};
+const unsigned char kSwapMask64[16] = {7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8};
+
+// Each kernel swaps as many whole vectors as fit in length and returns the
+// number of bytes it processed, leaving the tail to the scalar loop.
+typedef size_t (*SwapBlocksKernel)(unsigned char* data, size_t length, const unsigned char* mask);
+
+__attribute__((target("ssse3")))
+size_t swapBlocksSsse3(unsigned char* data, size_t length, const unsigned char* mask) {
+  const __m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask));
+  size_t i = 0;
+
+  for (; i + 16 <= length; i += 16) {
+    __m128i* block = reinterpret_cast<__m128i*>(data + i);
+    _mm_storeu_si128(block, _mm_shuffle_epi8(_mm_loadu_si128(block), shuffle));
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2")))
+size_t swapBlocksAvx2(unsigned char* data, size_t length, const unsigned char* mask) {
+  const __m256i shuffle = _mm256_broadcastsi128_si256(
+    _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask)));
+  size_t i = 0;
+
+  for (; i + 32 <= length; i += 32) {
+    __m256i* block = reinterpret_cast<__m256i*>(data + i);
+    _mm256_storeu_si256(block, _mm256_shuffle_epi8(_mm256_loadu_si256(block), shuffle));
+  }
+
+  return i;
+}
+
+void swapEndianArrayWith(SwapBlocksKernel kernel, unsigned char* data, size_t element_size, size_t count) {
+  size_t length = element_size * count;
+  size_t swapped = 0;
+
+  switch (element_size) {
+    case 2: swapped = kernel(data, length, kSwapMask16); break;
+    case 4: swapped = kernel(data, length, kSwapMask32); break;
+    case 8: swapped = kernel(data, length, kSwapMask64); break;
+  }
+
+  swapBlocksScalar(data + swapped, element_size, length - swapped);
+}
+
+#endif  // ANH_BYTE_BUFFER_SIMD_SWAP
+
+typedef void (*SwapArrayKernel)(unsigned char* data, size_t element_size, size_t count);
+
+SwapArrayKernel selectSwapArrayKernel() {
+  if (swapEndianArrayAvx2Supported()) {
+    return swapEndianArrayAvx2;
+  }
+
+  if (swapEndianArraySsse3Supported()) {
+    return swapEndianArraySsse3;
+  }
+
+  return swapEndianArrayPortable;
+}
+
+}  // namespace
+
+void swapEndianArrayPortable(unsigned char* data, size_t element_size, size_t count) {
+  swapBlocksScalar(data, element_size, element_size * count);
+}
+
+#ifdef ANH_BYTE_BUFFER_SIMD_SWAP
+
+void swapEndianArraySsse3(unsigned char* data, size_t element_size, size_t count) {
+  swapEndianArrayWith(swapBlocksSsse3, data, element_size, count);
+}
+
+void swapEndianArrayAvx2(unsigned char* data, size_t element_size, size_t count) {
+  swapEndianArrayWith(swapBlocksAvx2, data, element_size, count);
+}
+
+bool swapEndianArraySsse3Supported() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("ssse3");
+}
+
+bool swapEndianArrayAvx2Supported() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+void swapEndianArraySsse3(unsigned char* data, size_t element_size, size_t count) {
+  swapEndianArrayPortable(data, element_size, count);
+}
+
+void swapEndianArrayAvx2(unsigned char* data, size_t element_size, size_t count) {
+  swapEndianArrayPortable(data, element_size, count);
+}
+
+bool swapEndianArraySsse3Supported() {
+  return false;
+}
+
+bool swapEndianArrayAvx2Supported() {
+  return false;
+}
+
+#endif  // ANH_BYTE_BUFFER_SIMD_SWAP
+
 ByteBuffer::ByteBuffer()
 : read_position_(0)
 , write_position_(0) {}
@@ -22,7 +244,7 @@ ByteBuffer::ByteBuffer(size_t length)
 , write_position_(0) {}
 
 ByteBuffer::ByteBuffer(std::vector<unsigned char>& data)
-: data_(data.begin(), data.end())
+: data_(data.data(), data.data() + data.size())
 , read_position_(0)
 , write_position_(data.size()) {}
 
@@ -45,8 +267,29 @@ ByteBuffer& ByteBuffer::operator= (const ByteBuffer& from) {
   return *this;
 }
 
+ByteBuffer::ByteBuffer(ByteBuffer&& from)
+: data_(std::move(from.data_))
+, read_position_(from.read_position_)
+, write_position_(from.write_position_) {
+  from.read_position_ = 0;
+  from.write_position_ = 0;
+}
+
+ByteBuffer& ByteBuffer::operator= (ByteBuffer&& from) {
+  if (this != &from) {
+    data_ = std::move(from.data_);
+    read_position_ = from.read_position_;
+    write_position_ = from.write_position_;
+
+    from.read_position_ = 0;
+    from.write_position_ = 0;
+  }
+
+  return *this;
+}
+
 void ByteBuffer::swap(ByteBuffer& from) {
-  std::swap(data_, from.data_);
+  data_.swap(from.data_);
   std::swap(read_position_, from.read_position_);
   std::swap(write_position_, from.write_position_);
 }
@@ -59,6 +302,26 @@ void ByteBuffer::reserve(size_t length) {
   data_.reserve(length);
 }
 
+unsigned char* ByteBuffer::prepare(size_t length) {
+  size_t size = data_.size();
+
+  // Grow geometrically so repeated small reads don't reallocate every time.
+  if (data_.capacity() - size < length) {
+    data_.reserve(std::max(size + length, data_.capacity() * 2));
+  }
+
+  return data_.data() + size;
+}
+
+void ByteBuffer::commit(size_t length) {
+  if (data_.capacity() - data_.size() < length) {
+    throw std::out_of_range("Commit past end of prepared region");
+  }
+
+  data_.resize_uninitialized(data_.size() + length);
+  write_position_ = data_.size();
+}
+
 size_t ByteBuffer::size() const {
   return data_.size();
 }
@@ -73,6 +336,16 @@ void ByteBuffer::write(const unsigned char* data, size_t size) {
 }
 
 void ByteBuffer::write(size_t offset, const unsigned char* data, size_t size) {
+  // Overwriting bytes that already exist is done in place, which keeps
+  // backpatching a header independent of the length of the buffer.
+  if (offset <= data_.size() && data_.size() - offset >= size) {
+    if (size) {
+      std::memmove(&data_[offset], data, size);
+    }
+
+    return;
+  }
+
   if (data_.size() < offset) {
     data_.resize(offset * 2);
   }
@@ -106,70 +379,153 @@ void ByteBuffer::writePosition(size_t position) {
 }
 
 const unsigned char* ByteBuffer::data() const {
-  return &data_[0];
+  return data_.data();
 }
 
-std::vector<unsigned char>& ByteBuffer::raw() {
+ByteBuffer::Storage& ByteBuffer::raw() {
   return data_;
 }
 
-template<>
-void ByteBuffer::swapEndian(uint16_t& data) const {
-  swapEndian16(data);
+std::vector<unsigned char> ByteBuffer::vector() const {
+  return std::vector<unsigned char>(data_.begin(), data_.end());
 }
 
-template<>
-void ByteBuffer::swapEndian(uint32_t& data) const {
-  swapEndian32(data);
+void ByteBuffer::swapEndianArray(unsigned char* data, size_t element_size, size_t count) {
+  static const SwapArrayKernel kernel = selectSwapArrayKernel();
+  kernel(data, element_size, count);
 }
 
-template<>
-void ByteBuffer::swapEndian(uint64_t& data) const {
-  swapEndian64(data);
-}
+size_t ByteBuffer::varintSize(uint64_t value) {
+  size_t size = 1;
 
-template<>
-void ByteBuffer::swapEndian(int16_t& data) const {
-  swapEndian16(data);
-}
+  while (value >= 0x80) {
+    value >>= 7;
+    ++size;
+  }
 
-template<>
-void ByteBuffer::swapEndian(int32_t& data) const {
-  swapEndian32(data);
+  return size;
 }
 
-template<>
-void ByteBuffer::swapEndian(int64_t& data) const {
-  swapEndian64(data);
+void ByteBuffer::writeUnsignedVarint(uint64_t data) {
+  // Encode into a scratch array first so the vector only sees one insert.
+  unsigned char encoded[10];
+  size_t length = 0;
+
+  while (data >= 0x80) {
+    encoded[length++] = static_cast<unsigned char>(data | 0x80);
+    data >>= 7;
+  }
+
+  encoded[length++] = static_cast<unsigned char>(data);
+
+  write(encoded, length);
 }
 
-template<>
-ByteBuffer& ByteBuffer::write<std::string>(std::string data) {
-  write<uint16_t>(static_cast<uint16_t>(data.length()));
-  write(reinterpret_cast<const unsigned char*>(data.c_str()), data.length());
+uint64_t ByteBuffer::decodeUnsignedVarint(const unsigned char* source, size_t available, size_t* length) {
+  if (available == 0) {
+    throw std::out_of_range("Read past end of buffer");
+  }
 
-  return *this;
+  // Most varints are lengths and small ids that fit in one or two bytes, so
+  // handle those without entering the general loop.
+  uint64_t result = source[0];
+
+  if (result < 0x80) {
+    *length = 1;
+    return result;
+  }
+
+  // A zero in the final byte only adds padding, the writer never emits one.
+  if (available >= 2 && source[1] < 0x80) {
+    if (source[1] == 0) {
+      throw std::runtime_error("Varint is not minimally encoded");
+    }
+
+    *length = 2;
+    return (result & 0x7F) | (static_cast<uint64_t>(source[1]) << 7);
+  }
+
+  result &= 0x7F;
+
+  // A 64-bit value needs at most 10 bytes, the last holding a single bit.
+  size_t max_length = (available < 10) ? available : 10;
+
+  for (size_t i = 1; i < max_length; ++i) {
+    uint64_t byte = source[i];
+    result |= (byte & 0x7F) << (7 * i);
+
+    if (byte < 0x80) {
+      if (i == 9 && byte > 1) {
+        throw std::overflow_error("Varint exceeds 64 bits");
+      }
+
+      if (byte == 0) {
+        throw std::runtime_error("Varint is not minimally encoded");
+      }
+
+      *length = i + 1;
+      return result;
+    }
+  }
+
+  if (max_length == 10) {
+    throw std::overflow_error("Varint exceeds 64 bits");
+  }
+
+  throw std::out_of_range("Read past end of buffer");
 }
 
-template<>
-const std::string ByteBuffer::read<std::string>(bool do_swap_endian) {
-  uint16_t length = read<uint16_t>(do_swap_endian);
+StringView ByteBuffer::readStringView(bool doSwapEndian) {
+  uint16_t length = read<uint16_t>(doSwapEndian);
 
   if (data_.size() < read_position_ + length) {
     throw std::out_of_range("Read past end of buffer");
   }
 
-  std::string data(data_.begin() + read_position_,
-    data_.begin() + read_position_ + length);
+  StringView view(reinterpret_cast<const char*>(data_.data() + read_position_), length);
 
   read_position_ += length;
 
-  return data;
+  return view;
+}
+
+void ByteBuffer::readString(std::string& data, bool doSwapEndian) {
+  StringView view = readStringView(doSwapEndian);
+  data.assign(view.data(), view.length());
+}
+
+void ByteBuffer::readString(std::wstring& data, bool doSwapEndian) {
+  uint32_t length = read<uint32_t>(doSwapEndian);
+
+  if (data_.size() < read_position_ + (static_cast<size_t>(length) * 2)) {
+    throw std::out_of_range("Read past end of buffer");
+  }
+
+  data.resize(length);
+
+  if (length != 0) {
+    widenUtf16(&data_[read_position_], length, &data[0], doSwapEndian);
+  }
+
+  read_position_ += static_cast<size_t>(length) * 2;
+}
+
+template<>
+ByteBuffer& ByteBuffer::write<std::string>(const std::string& data) {
+  write<uint16_t>(static_cast<uint16_t>(data.length()));
+  write(reinterpret_cast<const unsigned char*>(data.c_str()), data.length());
+
+  return *this;
+}
+
+template<>
+const std::string ByteBuffer::read<std::string>(bool do_swap_endian) {
+  return readStringView(do_swap_endian).str();
 }
 
 template<>
-ByteBuffer& ByteBuffer::write<std::wstring>(std::wstring data) {
-  uint32_t length = data.length();
+ByteBuffer& ByteBuffer::write<std::wstring>(const std::wstring& data) {
+  uint32_t length = static_cast<uint32_t>(data.length());
 
   write<uint32_t>(length);
   
@@ -182,7 +538,7 @@ ByteBuffer& ByteBuffer::write<std::wstring>(std::wstring data) {
     data_.resize(write_position_ + length * 2);
   }
 
-  std::copy(data.begin(), data.end(), reinterpret_cast<uint16_t*>(&data_[write_position_]));
+  narrowToUtf16(data.data(), length, &data_[write_position_]);
 
   write_position_ += length * 2;
 
@@ -191,18 +547,8 @@ ByteBuffer& ByteBuffer::write<std::wstring>(std::wstring data) {
 
 template<>
 const std::wstring ByteBuffer::read<std::wstring>(bool do_swap_endian) {
-  uint32_t length = read<uint32_t>(do_swap_endian);
-
-  if (data_.size() < read_position_ + (length * 2)) {
-    throw std::out_of_range("Read past end of buffer");
-  }
-  
   std::wstring data;
-
-  for (size_t i = 0; i < length; ++i) {
-    data += *reinterpret_cast<uint16_t*>(&data_[read_position_]);
-    read_position_ += 2;
-  }
+  readString(data, do_swap_endian);
 
   return data;
 }
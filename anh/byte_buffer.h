@@ -6,17 +6,69 @@
 #define ANH_BYTE_BUFFER_H_
 
 #include <cstdint>
+#include <cstring>
+#include <limits>
 #include <vector>
 #include <string>
 #include <stdexcept>
+#include <type_traits>
+
+#include "anh/byte_order.h"
+#include "anh/small_vector.h"
+
+#ifndef ANH_BYTE_BUFFER_INLINE_SIZE
+/// The number of bytes a ByteBuffer stores inside the object before it
+/// allocates. Must be defined the same way for the library and its users.
+#define ANH_BYTE_BUFFER_INLINE_SIZE 64
+#endif
 
 /// The anh namespace hosts a number of useful utility classes intended
 /// to be used and reused in domain specific classes.
 namespace anh {
 
+/*! \brief A read-only view of string data stored inside a ByteBuffer.
+ *
+ * The view points directly into the buffer's storage and is only valid until
+ * the buffer is next modified.
+ */
+class StringView {
+public:
+    StringView() : data_(nullptr), length_(0) {}
+    StringView(const char* data, size_t length) : data_(data), length_(length) {}
+
+    const char* data() const { return data_; }
+    size_t length() const { return length_; }
+    bool empty() const { return length_ == 0; }
+
+    const char* begin() const { return data_; }
+    const char* end() const { return data_ + length_; }
+
+    /// \returns A copy of the viewed characters.
+    std::string str() const { return std::string(data_, length_); }
+
+    bool operator==(const StringView& other) const {
+        return length_ == other.length_ && (length_ == 0 || std::memcmp(data_, other.data_, length_) == 0);
+    }
+
+    bool operator!=(const StringView& other) const { return !(*this == other); }
+
+private:
+    const char* data_;
+    size_t length_;
+};
+
+/*! \brief A growable buffer of bytes with separate read and write positions.
+ *
+ * Small payloads, such as an event type ident and a few fields, are stored
+ * inside the object itself; the buffer only allocates once it grows past
+ * INLINE_CAPACITY bytes.
+ */
 class ByteBuffer {
 public:
     enum { SWAP_ENDIAN = 1 };
+    enum { INLINE_CAPACITY = ANH_BYTE_BUFFER_INLINE_SIZE };
+
+    typedef SmallVector<unsigned char, INLINE_CAPACITY> Storage;
 
 public:
     ByteBuffer();
@@ -27,16 +79,109 @@ public:
     
     ByteBuffer(const ByteBuffer& from);
     ByteBuffer& operator=(const ByteBuffer& from);
+
+    /// Takes over the heap storage of another buffer along with its read and
+    /// write positions, leaving it empty. Inline contents are copied.
+    ByteBuffer(ByteBuffer&& from);
+    ByteBuffer& operator=(ByteBuffer&& from);
     
     void swap(ByteBuffer& from); // NOLINT
     
     void append(const ByteBuffer& from);
     
-    template<typename T> ByteBuffer& write(T data);
+    template<typename T> ByteBuffer& write(const T& data);
     template<typename T> ByteBuffer& writeAt(size_t offset, T data);
     template<typename T> const T peek(bool doSwapEndian = false) const;
     template<typename T> const T peekAt(size_t offset, bool doSwapEndian = false) const;
     template<typename T> const T read(bool doSwapEndian = false);
+
+    /**
+     * Reads a string written by write<std::string> without copying it.
+     *
+     * \returns A view of the string's characters inside this buffer, valid
+     *      until the buffer is next modified.
+     * \throws std::out_of_range If the string runs past the end of the buffer.
+     */
+    StringView readStringView(bool doSwapEndian = false);
+
+    /**
+     * Reads a string written by write<std::string> into an existing string,
+     * reusing its storage when it is large enough.
+     *
+     * \param data The string to overwrite with the contents read.
+     */
+    void readString(std::string& data, bool doSwapEndian = false);
+
+    /**
+     * Reads a string written by write<std::wstring> into an existing string,
+     * reusing its storage when it is large enough.
+     *
+     * \param data The string to overwrite with the contents read.
+     * \param doSwapEndian Swaps the length and each UTF-16 character.
+     */
+    void readString(std::wstring& data, bool doSwapEndian = false);
+
+    /**
+     * Writes an array of arithmetic values with a single copy.
+     *
+     * \param data The first element of the array.
+     * \param count The number of elements to write.
+     */
+    template<typename T> ByteBuffer& writeArray(const T* data, size_t count);
+
+    /**
+     * Reads an array of arithmetic values with one bounds check and a single
+     * copy, byte swapping the whole array in bulk if requested.
+     *
+     * \param data The destination array, with room for at least count elements.
+     * \param count The number of elements to read.
+     * \throws std::out_of_range If the array runs past the end of the buffer.
+     */
+    template<typename T> void readArray(T* data, size_t count, bool doSwapEndian = false);
+
+    /**
+     * Writes an integer as an LEB128 varint, 7 bits per byte with the high bit
+     * marking continuation. Signed types are zigzag encoded first so small
+     * negative values stay short as well.
+     *
+     * \param data The integral value to write.
+     */
+    template<typename T> ByteBuffer& writeVarint(T data);
+
+    /**
+     * Reads an LEB128 varint written by writeVarint<T>.
+     *
+     * The read position only moves when a value is returned.
+     *
+     * \throws std::out_of_range If the varint runs past the end of the buffer.
+     * \throws std::overflow_error If the value does not fit in T.
+     * \throws std::runtime_error If the varint is padded with trailing zero
+     *      groups, which writeVarint never produces.
+     */
+    template<typename T> const T readVarint();
+
+    /// \returns The number of bytes writeVarint<uint64_t> uses for the value.
+    static size_t varintSize(uint64_t value);
+
+    /**
+     * Decodes an LEB128 varint from raw bytes, for readers of memory that is
+     * not held in a ByteBuffer.
+     *
+     * \param data The first byte of the varint.
+     * \param available The number of readable bytes at data.
+     * \param length Receives the number of bytes the varint takes up.
+     * \returns The decoded value, still zigzag encoded if it was signed.
+     * \throws The same exceptions as readVarint.
+     */
+    static uint64_t decodeUnsignedVarint(const unsigned char* data, size_t available, size_t* length);
+
+    /**
+     * Converts a decoded varint to T, undoing the zigzag encoding of signed
+     * types.
+     *
+     * \throws std::overflow_error If the value does not fit in T.
+     */
+    template<typename T> static T narrowVarint(uint64_t raw);
     
     void write(const unsigned char* data, size_t size);
     void write(size_t offset, const unsigned char* data, size_t size);
@@ -49,23 +194,200 @@ public:
     void writePosition(size_t position);
     
     void reserve(size_t length);
+
+    /**
+     * Makes room for at least length bytes past the end of the buffer so they
+     * can be filled in place, for example by a socket read. The bytes only
+     * become part of the buffer once they are committed.
+     *
+     * \param length The number of bytes to make room for.
+     * \returns The start of the spare region, valid until the buffer is next modified.
+     */
+    unsigned char* prepare(size_t length);
+
+    /**
+     * Appends bytes that were written into the region returned by prepare and
+     * moves the write position to the new end of the buffer.
+     *
+     * \param length The number of bytes written.
+     * \throws std::out_of_range If length exceeds the spare capacity.
+     */
+    void commit(size_t length);
+
     size_t size() const;
     size_t capacity() const;
     const unsigned char* data() const;
-    
-    std::vector<unsigned char>& raw();
+
+    /**
+     * \returns The underlying storage.
+     *
+     * \note This used to be a std::vector<unsigned char>&. Storage is a
+     * SmallVector, which offers the same members the library relies on
+     * (data, size, resize, insert, erase, operator[]) but cannot be bound to
+     * a std::vector reference. Code that needs a vector should call vector().
+     */
+    Storage& raw();
+
+    /// \returns A copy of the buffer's contents as a std::vector.
+    std::vector<unsigned char> vector() const;
+
+    /**
+     * Reverses the byte order of each element of an array in place.
+     *
+     * \param data The first byte of the array.
+     * \param element_size The size of each element in bytes.
+     * \param count The number of elements.
+     */
+    static void swapEndianArray(unsigned char* data, size_t element_size, size_t count);
 
 private:
-    template<typename T> void swapEndian(T& data) const;
-    template<typename T> void swapEndian16(T& data) const;
-    template<typename T> void swapEndian32(T& data) const;
-    template<typename T> void swapEndian64(T& data) const;
+
+    void writeUnsignedVarint(uint64_t data);
+
     
-    std::vector<unsigned char> data_;
+    Storage data_;
     size_t read_position_;
     size_t write_position_;
 };
 
+/**
+ * The implementations ByteBuffer::swapEndianArray chooses between, exposed so
+ * that tests and benchmarks can run each of them. The portable version swaps
+ * one element at a time; the others shuffle 16 or 32 bytes at a time and may
+ * only be called when the matching *Supported() function returns true.
+ */
+void swapEndianArrayPortable(unsigned char* data, size_t element_size, size_t count);
+void swapEndianArraySsse3(unsigned char* data, size_t element_size, size_t count);
+void swapEndianArrayAvx2(unsigned char* data, size_t element_size, size_t count);
+
+/// \returns True if the processor supports the SSSE3 instructions.
+bool swapEndianArraySsse3Supported();
+
+/// \returns True if the processor supports the AVX2 instructions.
+bool swapEndianArrayAvx2Supported();
+
+/*! \brief Writes values to a ByteBuffer in a byte order fixed at compile time.
+ *
+ * Arithmetic and enum values are written in the writer's byte order. Strings
+ * use the same length prefixed layout as ByteBuffer::write, with the length
+ * and any UTF-16 units in the writer's byte order.
+ *
+ * \code
+ * anh::BigEndianWriter writer(buffer);
+ * writer.write<uint32_t>(opcode).write<float>(position_x);
+ * \endcode
+ *
+ * \see NativeByteOrder, SwappedByteOrder, LittleEndianByteOrder, BigEndianByteOrder
+ */
+template<typename ByteOrder>
+class ByteBufferWriter {
+public:
+    explicit ByteBufferWriter(ByteBuffer& buffer);
+
+    template<typename T> ByteBufferWriter& write(const T& data);
+    template<typename T> ByteBufferWriter& writeAt(size_t offset, T data);
+
+    ByteBuffer& buffer() const;
+
+private:
+    template<typename T> void writeValue(T data);
+    void writeValue(const std::string& data);
+    void writeValue(const std::wstring& data);
+
+    ByteBuffer& buffer_;
+};
+
+/*! \brief Reads values from a ByteBuffer in a byte order fixed at compile time,
+ * so there is no swap flag to test on every read.
+ *
+ * Only arithmetic and enum values can be peeked. read() also accepts
+ * std::string and std::wstring, which are read as ByteBuffer::read reads them
+ * with the length and UTF-16 units in the reader's byte order.
+ *
+ * \code
+ * anh::BigEndianReader reader(buffer);
+ * uint32_t opcode = reader.read<uint32_t>();
+ * float position_x = reader.read<float>();
+ * \endcode
+ */
+template<typename ByteOrder>
+class ByteBufferReader {
+public:
+    explicit ByteBufferReader(ByteBuffer& buffer);
+
+    template<typename T> const T peek() const;
+    template<typename T> const T peekAt(size_t offset) const;
+    template<typename T> const T read();
+
+    ByteBuffer& buffer() const;
+
+private:
+    ByteBuffer& buffer_;
+};
+
+/*! \brief Reads fixed-size regions of a ByteBuffer with a single bounds check.
+ *
+ * require() checks that a whole region is available up front, after which
+ * get<T>() reads from it without further checks. Reading outside of the
+ * required region is caught by an assert in debug builds only. The read
+ * position is handed back to the buffer when the cursor is destroyed, and
+ * the buffer must not be modified while the cursor is alive.
+ *
+ * \code
+ * void onDeserialize(ByteBuffer& in) {
+ *     anh::ReadCursor cursor(in);
+ *     cursor.require(sizeof(uint64_t) + sizeof(float) * 3);
+ *
+ *     target_ = cursor.get<uint64_t>();
+ *     x_ = cursor.get<float>();
+ *     y_ = cursor.get<float>();
+ *     z_ = cursor.get<float>();
+ * }
+ * \endcode
+ */
+template<typename ByteOrder>
+class BasicReadCursor {
+public:
+    /// Starts reading at the buffer's current read position.
+    explicit BasicReadCursor(ByteBuffer& buffer);
+
+    /// Commits the bytes consumed back to the buffer's read position.
+    ~BasicReadCursor();
+
+    /**
+     * Checks that a region of the given length can be read from the current
+     * position, replacing any previously required region.
+     *
+     * \param length The size of the region in bytes.
+     * \throws std::out_of_range If the buffer holds fewer than length bytes.
+     */
+    BasicReadCursor& require(size_t length);
+
+    /// Reads an arithmetic or enum value from the required region without a
+    /// bounds check.
+    template<typename T> const T get();
+
+    /// \returns The number of bytes left in the required region.
+    size_t remaining() const;
+
+private:
+    /// Disable copying, only one cursor may own the read position.
+    BasicReadCursor(const BasicReadCursor&);
+    BasicReadCursor& operator=(const BasicReadCursor&);
+
+    ByteBuffer& buffer_;
+    const unsigned char* position_;
+    const unsigned char* region_end_;
+};
+
+typedef BasicReadCursor<NativeByteOrder> ReadCursor;
+typedef BasicReadCursor<BigEndianByteOrder> BigEndianReadCursor;
+
+typedef ByteBufferWriter<LittleEndianByteOrder> LittleEndianWriter;
+typedef ByteBufferWriter<BigEndianByteOrder> BigEndianWriter;
+typedef ByteBufferReader<LittleEndianByteOrder> LittleEndianReader;
+typedef ByteBufferReader<BigEndianByteOrder> BigEndianReader;
+
 }  // namespace anh
 
 // Move inline implementations to a separate file to
@@ -0,0 +1,411 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/byte_buffer.h"
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+using anh::ByteBuffer;
+
+// Wrapping benchmarks in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+const int kValueCount = 4096;
+
+// Builds a set of subject ids that mirrors live traffic: mostly small values
+// with the occasional full width one. The argument is the largest bit width
+// the common case uses.
+std::vector<uint64_t> makeSubjects(int max_bits) {
+    std::mt19937_64 generator(42);
+    std::vector<uint64_t> values(kValueCount);
+
+    for (int i = 0; i < kValueCount; ++i) {
+        uint64_t value = generator();
+        values[i] = (i % 64 == 0) ? value : (value >> (64 - max_bits));
+    }
+
+    return values;
+}
+
+void BM_WriteFixedUint64(benchmark::State& state) {
+    std::vector<uint64_t> values = makeSubjects(static_cast<int>(state.range(0)));
+    ByteBuffer buffer;
+
+    for (auto _ : state) {
+        buffer.clear();
+        for (int i = 0; i < kValueCount; ++i) {
+            buffer.write<uint64_t>(values[i]);
+        }
+        benchmark::DoNotOptimize(buffer.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * kValueCount);
+    state.counters["bytes_per_value"] = static_cast<double>(buffer.size()) / kValueCount;
+}
+BENCHMARK(BM_WriteFixedUint64)->Arg(7)->Arg(14)->Arg(28);
+
+void BM_WriteVarintUint64(benchmark::State& state) {
+    std::vector<uint64_t> values = makeSubjects(static_cast<int>(state.range(0)));
+    ByteBuffer buffer;
+
+    for (auto _ : state) {
+        buffer.clear();
+        for (int i = 0; i < kValueCount; ++i) {
+            buffer.writeVarint<uint64_t>(values[i]);
+        }
+        benchmark::DoNotOptimize(buffer.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * kValueCount);
+    state.counters["bytes_per_value"] = static_cast<double>(buffer.size()) / kValueCount;
+}
+BENCHMARK(BM_WriteVarintUint64)->Arg(7)->Arg(14)->Arg(28);
+
+void BM_ReadFixedUint64(benchmark::State& state) {
+    std::vector<uint64_t> values = makeSubjects(static_cast<int>(state.range(0)));
+    ByteBuffer buffer;
+    for (int i = 0; i < kValueCount; ++i) {
+        buffer.write<uint64_t>(values[i]);
+    }
+
+    for (auto _ : state) {
+        buffer.readPosition(0);
+        uint64_t sum = 0;
+        for (int i = 0; i < kValueCount; ++i) {
+            sum += buffer.read<uint64_t>();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(state.iterations() * kValueCount);
+}
+BENCHMARK(BM_ReadFixedUint64)->Arg(7)->Arg(14)->Arg(28);
+
+void BM_ReadVarintUint64(benchmark::State& state) {
+    std::vector<uint64_t> values = makeSubjects(static_cast<int>(state.range(0)));
+    ByteBuffer buffer;
+    for (int i = 0; i < kValueCount; ++i) {
+        buffer.writeVarint<uint64_t>(values[i]);
+    }
+
+    for (auto _ : state) {
+        buffer.readPosition(0);
+        uint64_t sum = 0;
+        for (int i = 0; i < kValueCount; ++i) {
+            sum += buffer.readVarint<uint64_t>();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(state.iterations() * kValueCount);
+}
+BENCHMARK(BM_ReadVarintUint64)->Arg(7)->Arg(14)->Arg(28);
+
+void BM_WriteUint32PerElement(benchmark::State& state) {
+    std::vector<uint32_t> values(state.range(0), 0x01020304);
+    ByteBuffer buffer;
+
+    for (auto _ : state) {
+        buffer.clear();
+        for (size_t i = 0; i < values.size(); ++i) {
+            buffer.write<uint32_t>(values[i]);
+        }
+        benchmark::DoNotOptimize(buffer.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * values.size() * sizeof(uint32_t));
+}
+BENCHMARK(BM_WriteUint32PerElement)->Arg(64)->Arg(4096);
+
+void BM_WriteUint32Array(benchmark::State& state) {
+    std::vector<uint32_t> values(state.range(0), 0x01020304);
+    ByteBuffer buffer;
+
+    for (auto _ : state) {
+        buffer.clear();
+        buffer.writeArray(&values[0], values.size());
+        benchmark::DoNotOptimize(buffer.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * values.size() * sizeof(uint32_t));
+}
+BENCHMARK(BM_WriteUint32Array)->Arg(64)->Arg(4096);
+
+template<typename T>
+void BM_ReadSwappedPerElement(benchmark::State& state) {
+    std::vector<T> values(state.range(0), 0x01);
+    ByteBuffer buffer;
+    buffer.writeArray(&values[0], values.size());
+
+    for (auto _ : state) {
+        buffer.readPosition(0);
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = buffer.read<T>(true);
+        }
+        benchmark::DoNotOptimize(&values[0]);
+    }
+
+    state.SetBytesProcessed(state.iterations() * values.size() * sizeof(T));
+}
+BENCHMARK_TEMPLATE(BM_ReadSwappedPerElement, uint16_t)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_ReadSwappedPerElement, uint32_t)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_ReadSwappedPerElement, uint64_t)->Arg(4096);
+
+template<typename T>
+void BM_ReadSwappedArray(benchmark::State& state) {
+    std::vector<T> values(state.range(0), 0x01);
+    ByteBuffer buffer;
+    buffer.writeArray(&values[0], values.size());
+
+    for (auto _ : state) {
+        buffer.readPosition(0);
+        buffer.readArray(&values[0], values.size(), true);
+        benchmark::DoNotOptimize(&values[0]);
+    }
+
+    state.SetBytesProcessed(state.iterations() * values.size() * sizeof(T));
+}
+BENCHMARK_TEMPLATE(BM_ReadSwappedArray, uint16_t)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_ReadSwappedArray, uint32_t)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_ReadSwappedArray, uint64_t)->Arg(4096);
+
+// A decoded event with twenty fields, the shape of a typical onDeserialize.
+struct DecodedState {
+    uint64_t subject;
+    uint32_t flags[4];
+    float position[3];
+    float orientation[4];
+    uint16_t stats[8];
+};
+
+ByteBuffer makeEncodedState() {
+    ByteBuffer buffer;
+    buffer.write<uint64_t>(12345);
+    for (int i = 0; i < 4; ++i) buffer.write<uint32_t>(i);
+    for (int i = 0; i < 7; ++i) buffer.write<float>(i * 0.5f);
+    for (int i = 0; i < 8; ++i) buffer.write<uint16_t>(i);
+    return buffer;
+}
+
+void BM_DecodeEventWithRead(benchmark::State& state) {
+    ByteBuffer buffer = makeEncodedState();
+    DecodedState decoded;
+
+    for (auto _ : state) {
+        buffer.readPosition(0);
+        decoded.subject = buffer.read<uint64_t>();
+        for (int i = 0; i < 4; ++i) decoded.flags[i] = buffer.read<uint32_t>();
+        for (int i = 0; i < 3; ++i) decoded.position[i] = buffer.read<float>();
+        for (int i = 0; i < 4; ++i) decoded.orientation[i] = buffer.read<float>();
+        for (int i = 0; i < 8; ++i) decoded.stats[i] = buffer.read<uint16_t>();
+        benchmark::DoNotOptimize(&decoded);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DecodeEventWithRead);
+
+void BM_DecodeEventWithCursor(benchmark::State& state) {
+    ByteBuffer buffer = makeEncodedState();
+    DecodedState decoded;
+
+    for (auto _ : state) {
+        buffer.readPosition(0);
+        anh::ReadCursor cursor(buffer);
+        cursor.require(buffer.size());
+
+        decoded.subject = cursor.get<uint64_t>();
+        for (int i = 0; i < 4; ++i) decoded.flags[i] = cursor.get<uint32_t>();
+        for (int i = 0; i < 3; ++i) decoded.position[i] = cursor.get<float>();
+        for (int i = 0; i < 4; ++i) decoded.orientation[i] = cursor.get<float>();
+        for (int i = 0; i < 8; ++i) decoded.stats[i] = cursor.get<uint16_t>();
+        benchmark::DoNotOptimize(&decoded);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DecodeEventWithCursor);
+
+// Typed writes and reads of every width, the second argument selects the
+// byte swapped path used for big endian protocols.
+template<typename T>
+void BM_WriteTyped(benchmark::State& state) {
+    ByteBuffer buffer;
+    buffer.reserve(kValueCount * sizeof(T));
+
+    for (auto _ : state) {
+        buffer.clear();
+        if (state.range(0)) {
+            anh::ByteBufferWriter<anh::SwappedByteOrder> writer(buffer);
+            for (int i = 0; i < kValueCount; ++i) {
+                writer.write<T>(static_cast<T>(i));
+            }
+        } else {
+            for (int i = 0; i < kValueCount; ++i) {
+                buffer.write<T>(static_cast<T>(i));
+            }
+        }
+        benchmark::DoNotOptimize(buffer.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * kValueCount * sizeof(T));
+}
+BENCHMARK_TEMPLATE(BM_WriteTyped, uint8_t)->Arg(0);
+BENCHMARK_TEMPLATE(BM_WriteTyped, uint16_t)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_WriteTyped, uint32_t)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_WriteTyped, uint64_t)->Arg(0)->Arg(1);
+
+template<typename T>
+void BM_ReadTyped(benchmark::State& state) {
+    bool swap = state.range(0) != 0;
+
+    ByteBuffer buffer;
+    for (int i = 0; i < kValueCount; ++i) {
+        buffer.write<T>(static_cast<T>(i));
+    }
+
+    for (auto _ : state) {
+        buffer.readPosition(0);
+        T sum = 0;
+        for (int i = 0; i < kValueCount; ++i) {
+            sum += buffer.read<T>(swap);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetBytesProcessed(state.iterations() * kValueCount * sizeof(T));
+}
+BENCHMARK_TEMPLATE(BM_ReadTyped, uint8_t)->Arg(0);
+BENCHMARK_TEMPLATE(BM_ReadTyped, uint16_t)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_ReadTyped, uint32_t)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_ReadTyped, uint64_t)->Arg(0)->Arg(1);
+
+void BM_StringRoundTrip(benchmark::State& state) {
+    std::string data(static_cast<size_t>(state.range(0)), 'a');
+    std::string result;
+    ByteBuffer buffer;
+
+    for (auto _ : state) {
+        buffer.clear();
+        buffer.write<std::string>(data);
+        buffer.readString(result);
+        benchmark::DoNotOptimize(result.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * data.length());
+}
+BENCHMARK(BM_StringRoundTrip)->Arg(8)->Arg(64)->Arg(512);
+
+void BM_WideStringRoundTrip(benchmark::State& state) {
+    std::wstring data(static_cast<size_t>(state.range(0)), L'a');
+    std::wstring result;
+    ByteBuffer buffer;
+
+    for (auto _ : state) {
+        buffer.clear();
+        buffer.write<std::wstring>(data);
+        buffer.readString(result);
+        benchmark::DoNotOptimize(result.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * data.length() * 2);
+}
+BENCHMARK(BM_WideStringRoundTrip)->Arg(8)->Arg(64)->Arg(512);
+
+// Backpatching length and count fields into an already written message.
+void BM_WriteAtPatch(benchmark::State& state) {
+    ByteBuffer buffer(static_cast<size_t>(state.range(0)));
+    size_t last = buffer.size() - sizeof(uint32_t);
+
+    for (auto _ : state) {
+        for (size_t offset = 0; offset <= last; offset += 64) {
+            buffer.writeAt<uint32_t>(offset, static_cast<uint32_t>(offset));
+        }
+        benchmark::DoNotOptimize(buffer.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * (last / 64 + 1));
+}
+BENCHMARK(BM_WriteAtPatch)->Arg(64)->Arg(4096);
+
+void BM_Append(benchmark::State& state) {
+    ByteBuffer from(static_cast<size_t>(state.range(0)));
+    ByteBuffer buffer;
+
+    for (auto _ : state) {
+        buffer.clear();
+        for (int i = 0; i < 16; ++i) {
+            buffer.append(from);
+        }
+        benchmark::DoNotOptimize(buffer.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * 16 * from.size());
+}
+BENCHMARK(BM_Append)->Arg(16)->Arg(256)->Arg(4096);
+
+void BM_CopyConstruct(benchmark::State& state) {
+    ByteBuffer from(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        ByteBuffer copy(from);
+        benchmark::DoNotOptimize(copy.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * from.size());
+}
+BENCHMARK(BM_CopyConstruct)->Arg(16)->Arg(256)->Arg(4096);
+
+// Moves the contents out and back again, so each iteration is one move
+// construction and one move assignment.
+void BM_MoveConstruct(benchmark::State& state) {
+    ByteBuffer from(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        ByteBuffer moved(std::move(from));
+        benchmark::DoNotOptimize(moved.data());
+        from = std::move(moved);
+    }
+
+    state.SetBytesProcessed(state.iterations() * from.size());
+}
+BENCHMARK(BM_MoveConstruct)->Arg(16)->Arg(256)->Arg(4096);
+
+void BM_Swap(benchmark::State& state) {
+    ByteBuffer first(static_cast<size_t>(state.range(0)));
+    ByteBuffer second(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        first.swap(second);
+        benchmark::DoNotOptimize(first.data());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Swap)->Arg(16)->Arg(256)->Arg(4096);
+
+void BM_Hexdump(benchmark::State& state) {
+    ByteBuffer buffer;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        buffer.write<uint8_t>(static_cast<uint8_t>(i));
+    }
+
+    std::ostringstream stream;
+    for (auto _ : state) {
+        stream.str(std::string());
+        stream << buffer;
+        benchmark::DoNotOptimize(stream.str().data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_Hexdump)->Arg(64)->Arg(1024);
+
+}  // namespace
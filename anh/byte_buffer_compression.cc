@@ -0,0 +1,141 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/byte_buffer_compression.h"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <zlib.h>
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+namespace {
+
+void writeHeader(unsigned char* header, CompressionAlgorithm algorithm,
+    uint32_t raw_size, uint32_t stored_size) {
+    header[0] = static_cast<uint8_t>(algorithm);
+    std::memcpy(header + sizeof(uint8_t), &raw_size, sizeof(raw_size));
+    std::memcpy(header + sizeof(uint8_t) + sizeof(uint32_t), &stored_size, sizeof(stored_size));
+}
+
+}  // namespace
+
+CompressionAlgorithm compressInto(const ByteBuffer& in, ByteBuffer& out, size_t threshold, int level) {
+    if (in.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("Payload too large to compress");
+    }
+
+    uint32_t raw_size = static_cast<uint32_t>(in.size());
+    size_t header_position = out.writePosition();
+    size_t payload_position = header_position + kCompressionHeaderSize;
+
+    if (raw_size > 0 && raw_size >= threshold) {
+        ByteBuffer::Storage& storage = out.raw();
+        uLong bound = compressBound(raw_size);
+
+        // Open a gap big enough for the worst case and let zlib deflate
+        // directly into it, then close up whatever it did not use.
+        storage.insert(storage.begin() + header_position, kCompressionHeaderSize + bound, 0);
+
+        uLongf stored_size = bound;
+        int result = compress2(&storage[payload_position], &stored_size, in.data(), raw_size, level);
+
+        if (result == Z_OK && stored_size < raw_size) {
+            storage.erase(storage.begin() + payload_position + stored_size,
+                storage.begin() + payload_position + bound);
+
+            writeHeader(&storage[header_position], COMPRESSION_ZLIB,
+                raw_size, static_cast<uint32_t>(stored_size));
+            out.writePosition(payload_position + stored_size);
+
+            return COMPRESSION_ZLIB;
+        }
+
+        storage.erase(storage.begin() + header_position, storage.begin() + payload_position + bound);
+    }
+
+    unsigned char header[kCompressionHeaderSize];
+    writeHeader(header, COMPRESSION_NONE, raw_size, raw_size);
+
+    out.write(header, kCompressionHeaderSize);
+    out.write(in.data(), raw_size);
+
+    return COMPRESSION_NONE;
+}
+
+void decompressFrom(ByteBuffer& in, ByteBuffer& out, size_t max_size) {
+    uint8_t algorithm;
+    uint32_t raw_size;
+    uint32_t stored_size;
+
+    size_t frame_position = in.readPosition();
+
+    {
+        ReadCursor cursor(in);
+        cursor.require(kCompressionHeaderSize);
+
+        algorithm = cursor.get<uint8_t>();
+        raw_size = cursor.get<uint32_t>();
+        stored_size = cursor.get<uint32_t>();
+    }
+
+    size_t payload_position = in.readPosition();
+
+    if (in.size() - payload_position < stored_size) {
+        in.readPosition(frame_position);
+        throw std::out_of_range("Read past end of buffer");
+    }
+
+    if (raw_size > max_size) {
+        in.readPosition(frame_position);
+        throw std::runtime_error("Compressed payload exceeds maximum size");
+    }
+
+    const unsigned char* payload = in.data() + payload_position;
+
+    switch (algorithm) {
+        case COMPRESSION_NONE: {
+            if (stored_size != raw_size) {
+                in.readPosition(frame_position);
+                throw std::runtime_error("Corrupt compressed payload");
+            }
+
+            out.write(payload, raw_size);
+            break;
+        }
+
+        case COMPRESSION_ZLIB: {
+            ByteBuffer::Storage& storage = out.raw();
+            size_t output_position = out.writePosition();
+
+            // Size the destination once from the header and inflate in place.
+            storage.insert(storage.begin() + output_position, raw_size, 0);
+
+            uLongf inflated_size = raw_size;
+            int result = uncompress(storage.data() + output_position, &inflated_size, payload, stored_size);
+
+            if (result != Z_OK || inflated_size != raw_size) {
+                storage.erase(storage.begin() + output_position,
+                    storage.begin() + output_position + raw_size);
+                in.readPosition(frame_position);
+                throw std::runtime_error("Corrupt compressed payload");
+            }
+
+            out.writePosition(output_position + raw_size);
+            break;
+        }
+
+        default:
+            in.readPosition(frame_position);
+            throw std::runtime_error("Unknown compression algorithm");
+    }
+
+    in.readPosition(payload_position + stored_size);
+}
+
+}  // namespace anh
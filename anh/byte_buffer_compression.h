@@ -0,0 +1,64 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#ifndef ANH_BYTE_BUFFER_COMPRESSION_H_
+#define ANH_BYTE_BUFFER_COMPRESSION_H_
+
+#include <cstdint>
+
+#include "anh/byte_buffer.h"
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+/// Identifies how the payload of a compression frame is stored.
+enum CompressionAlgorithm {
+    COMPRESSION_NONE = 0,
+    COMPRESSION_ZLIB = 1
+};
+
+/// Payloads smaller than this are not worth compressing and are stored as is.
+const size_t kDefaultCompressionThreshold = 128;
+
+/// The largest payload decompressFrom accepts unless told otherwise.
+const size_t kDefaultMaxDecompressedSize = 64 * 1024 * 1024;
+
+/// Size of the frame header: algorithm (uint8), raw size and stored size (uint32).
+const size_t kCompressionHeaderSize = sizeof(uint8_t) + sizeof(uint32_t) * 2;
+
+/**
+ * Compresses the full contents of a buffer into a frame written at the write
+ * position of another buffer. The frame carries the algorithm, the raw size
+ * and the stored size so it can be decoded without any outside information.
+ *
+ * Payloads below the threshold, or that zlib cannot shrink, are stored
+ * uncompressed in the same frame format.
+ *
+ * \param in The buffer to compress.
+ * \param out The buffer to write the frame to.
+ * \param threshold The smallest payload that is compressed.
+ * \param level The zlib compression level, 1-9 or -1 for zlib's default.
+ * \returns The algorithm used to store the payload.
+ */
+CompressionAlgorithm compressInto(const ByteBuffer& in, ByteBuffer& out,
+    size_t threshold = kDefaultCompressionThreshold, int level = -1);
+
+/**
+ * Reads a frame written by compressInto from the read position of a buffer
+ * and writes the original payload at the write position of another. The
+ * destination is sized once from the frame header and zlib inflates straight
+ * into it.
+ *
+ * \param in The buffer to read the frame from.
+ * \param out The buffer to write the decompressed payload to.
+ * \param max_size The largest raw size accepted from the frame header.
+ * \throws std::out_of_range If the frame runs past the end of the buffer.
+ * \throws std::runtime_error If the frame is malformed or too large.
+ */
+void decompressFrom(ByteBuffer& in, ByteBuffer& out, size_t max_size = kDefaultMaxDecompressedSize);
+
+}  // namespace anh
+
+#endif  // ANH_BYTE_BUFFER_COMPRESSION_H_
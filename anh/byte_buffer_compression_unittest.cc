@@ -0,0 +1,182 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/byte_buffer_compression.h"
+
+#include <gtest/gtest.h>
+
+using anh::ByteBuffer;
+using anh::compressInto;
+using anh::decompressFrom;
+
+// Wrapping tests in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+ByteBuffer makeRepetitivePayload(size_t size) {
+    ByteBuffer payload;
+    for (size_t i = 0; i < size; ++i) {
+        payload.write<uint8_t>(static_cast<uint8_t>(i % 16));
+    }
+
+    return payload;
+}
+
+ByteBuffer makeNoisyPayload(size_t size) {
+    ByteBuffer payload;
+    uint32_t state = 0x12345678;
+    for (size_t i = 0; i < size; ++i) {
+        state = state * 1664525 + 1013904223;
+        payload.write<uint8_t>(static_cast<uint8_t>(state >> 24));
+    }
+
+    return payload;
+}
+
+TEST(ByteBufferCompressionTests, CompressedFrameRoundTrips)
+{
+    ByteBuffer payload = makeRepetitivePayload(4096);
+
+    ByteBuffer frame;
+    EXPECT_EQ(anh::COMPRESSION_ZLIB, compressInto(payload, frame));
+    EXPECT_LT(frame.size(), payload.size());
+    EXPECT_EQ(frame.size(), frame.writePosition());
+
+    ByteBuffer result;
+    decompressFrom(frame, result);
+
+    ASSERT_EQ(payload.size(), result.size());
+    EXPECT_EQ(0, memcmp(payload.data(), result.data(), payload.size()));
+    EXPECT_EQ(result.size(), result.writePosition());
+    EXPECT_EQ(frame.size(), frame.readPosition());
+}
+
+TEST(ByteBufferCompressionTests, SmallPayloadIsStoredUncompressed)
+{
+    ByteBuffer payload = makeRepetitivePayload(64);
+
+    ByteBuffer frame;
+    EXPECT_EQ(anh::COMPRESSION_NONE, compressInto(payload, frame));
+    EXPECT_EQ(anh::kCompressionHeaderSize + payload.size(), frame.size());
+
+    ByteBuffer result;
+    decompressFrom(frame, result);
+
+    ASSERT_EQ(payload.size(), result.size());
+    EXPECT_EQ(0, memcmp(payload.data(), result.data(), payload.size()));
+}
+
+TEST(ByteBufferCompressionTests, IncompressiblePayloadIsStoredUncompressed)
+{
+    ByteBuffer payload = makeNoisyPayload(1024);
+
+    ByteBuffer frame;
+    EXPECT_EQ(anh::COMPRESSION_NONE, compressInto(payload, frame));
+    EXPECT_EQ(anh::kCompressionHeaderSize + payload.size(), frame.size());
+
+    ByteBuffer result;
+    decompressFrom(frame, result);
+
+    ASSERT_EQ(payload.size(), result.size());
+    EXPECT_EQ(0, memcmp(payload.data(), result.data(), payload.size()));
+}
+
+TEST(ByteBufferCompressionTests, EmptyPayloadRoundTrips)
+{
+    ByteBuffer payload;
+
+    ByteBuffer frame;
+    EXPECT_EQ(anh::COMPRESSION_NONE, compressInto(payload, frame, 0));
+
+    ByteBuffer result;
+    decompressFrom(frame, result);
+
+    EXPECT_EQ(0u, result.size());
+    EXPECT_EQ(frame.size(), frame.readPosition());
+}
+
+TEST(ByteBufferCompressionTests, FramesAreWrittenAfterExistingData)
+{
+    ByteBuffer first = makeRepetitivePayload(2048);
+    ByteBuffer second = makeRepetitivePayload(32);
+
+    ByteBuffer frames;
+    frames.write<uint32_t>(0xDEADBEEF);
+    compressInto(first, frames);
+    compressInto(second, frames);
+    frames.write<uint32_t>(0xCAFEBABE);
+
+    EXPECT_EQ(0xDEADBEEF, frames.read<uint32_t>());
+
+    ByteBuffer result;
+    result.write<uint16_t>(7);
+    decompressFrom(frames, result);
+    decompressFrom(frames, result);
+
+    EXPECT_EQ(0xCAFEBABE, frames.read<uint32_t>());
+
+    ASSERT_EQ(sizeof(uint16_t) + first.size() + second.size(), result.size());
+    EXPECT_EQ(7, result.read<uint16_t>());
+    EXPECT_EQ(0, memcmp(first.data(), result.data() + sizeof(uint16_t), first.size()));
+    EXPECT_EQ(0, memcmp(second.data(), result.data() + sizeof(uint16_t) + first.size(), second.size()));
+}
+
+TEST(ByteBufferCompressionTests, TruncatedFrameThrowsException)
+{
+    ByteBuffer payload = makeRepetitivePayload(4096);
+
+    ByteBuffer frame;
+    compressInto(payload, frame);
+    frame.raw().resize(frame.size() - 1);
+
+    ByteBuffer result;
+    EXPECT_THROW(decompressFrom(frame, result), std::out_of_range);
+    EXPECT_EQ(0u, frame.readPosition());
+    EXPECT_EQ(0u, result.size());
+
+    ByteBuffer header_only;
+    header_only.write<uint8_t>(anh::COMPRESSION_ZLIB);
+    EXPECT_THROW(decompressFrom(header_only, result), std::out_of_range);
+}
+
+TEST(ByteBufferCompressionTests, CorruptPayloadThrowsException)
+{
+    ByteBuffer payload = makeRepetitivePayload(4096);
+
+    ByteBuffer frame;
+    compressInto(payload, frame);
+
+    // Flip bits in the middle of the deflate stream.
+    frame.raw()[anh::kCompressionHeaderSize + 8] ^= 0xFF;
+    frame.raw()[anh::kCompressionHeaderSize + 9] ^= 0xFF;
+
+    ByteBuffer result;
+    EXPECT_THROW(decompressFrom(frame, result), std::runtime_error);
+    EXPECT_EQ(0u, result.size());
+    EXPECT_EQ(0u, result.writePosition());
+}
+
+TEST(ByteBufferCompressionTests, OversizedPayloadThrowsException)
+{
+    ByteBuffer payload = makeRepetitivePayload(4096);
+
+    ByteBuffer frame;
+    compressInto(payload, frame);
+
+    ByteBuffer result;
+    EXPECT_THROW(decompressFrom(frame, result, 1024), std::runtime_error);
+    EXPECT_EQ(0u, result.size());
+}
+
+TEST(ByteBufferCompressionTests, UnknownAlgorithmThrowsException)
+{
+    ByteBuffer frame;
+    frame.write<uint8_t>(42);
+    frame.write<uint32_t>(0);
+    frame.write<uint32_t>(0);
+
+    ByteBuffer result;
+    EXPECT_THROW(decompressFrom(frame, result), std::runtime_error);
+}
+
+}  // namespace
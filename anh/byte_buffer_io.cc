@@ -0,0 +1,142 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/byte_buffer_io.h"
+
+#include <algorithm>
+
+#include <sys/uio.h>
+
+#include <boost/thread/tss.hpp>
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+namespace {
+
+// Spare capacity guaranteed before every read.
+const size_t kMinimumReadSpace = 4096;
+
+// Size of the area that catches whatever does not fit in the buffer.
+const size_t kReadOverflowSize = 65536;
+
+// Buffers gathered by a single writev, well below any platform's IOV_MAX.
+const size_t kMaxGatherBuffers = 64;
+
+struct ReadOverflow {
+    unsigned char bytes[kReadOverflowSize];
+};
+
+// Each thread gets its own overflow area on first use, which keeps 64KB off
+// the stack of every reader.
+boost::thread_specific_ptr<ReadOverflow> read_overflow;
+
+ReadOverflow& readOverflow() {
+    ReadOverflow* overflow = read_overflow.get();
+
+    if (!overflow) {
+        overflow = new ReadOverflow();
+        read_overflow.reset(overflow);
+    }
+
+    return *overflow;
+}
+
+// Writes up to kMaxGatherBuffers buffers with one writev and consumes the
+// written bytes from each of them in turn.
+ssize_t gatherWrite(int fd, ByteBuffer* const* buffers, size_t count) {
+    struct iovec regions[kMaxGatherBuffers] = {};
+
+    for (size_t i = 0; i < count; ++i) {
+        const ByteBuffer& buffer = *buffers[i];
+
+        regions[i].iov_base = const_cast<unsigned char*>(buffer.data() + buffer.readPosition());
+        regions[i].iov_len = buffer.size() - buffer.readPosition();
+    }
+
+    ssize_t result = writev(fd, regions, static_cast<int>(count));
+    if (result <= 0) {
+        return result;
+    }
+
+    size_t remaining = static_cast<size_t>(result);
+    for (size_t i = 0; i < count && remaining; ++i) {
+        size_t written = std::min(remaining, regions[i].iov_len);
+
+        buffers[i]->readPosition(buffers[i]->readPosition() + written);
+        remaining -= written;
+    }
+
+    return result;
+}
+
+// Returns the number of unread bytes across a run of buffers.
+size_t unreadBytes(ByteBuffer* const* buffers, size_t count) {
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        total += buffers[i]->size() - buffers[i]->readPosition();
+    }
+
+    return total;
+}
+
+}  // namespace
+
+ssize_t readFrom(int fd, ByteBuffer& buffer) {
+    ReadOverflow& overflow = readOverflow();
+
+    struct iovec regions[2];
+    regions[0].iov_base = buffer.prepare(kMinimumReadSpace);
+    regions[0].iov_len = buffer.capacity() - buffer.size();
+    regions[1].iov_base = overflow.bytes;
+    regions[1].iov_len = sizeof(overflow.bytes);
+
+    ssize_t result = readv(fd, regions, 2);
+    if (result <= 0) {
+        return result;
+    }
+
+    size_t received = static_cast<size_t>(result);
+    size_t in_place = std::min(received, regions[0].iov_len);
+
+    buffer.commit(in_place);
+
+    if (received > in_place) {
+        buffer.write(overflow.bytes, received - in_place);
+    }
+
+    return result;
+}
+
+ssize_t writeTo(int fd, ByteBuffer& buffer) {
+    ByteBuffer* buffers[] = { &buffer };
+    return writeTo(fd, buffers, 1);
+}
+
+ssize_t writeTo(int fd, ByteBuffer* const* buffers, size_t count) {
+    ssize_t total = 0;
+
+    // Longer lists go out in batches, moving on only once a batch has been
+    // written in full so the bytes stay in order.
+    for (size_t first = 0; first < count; first += kMaxGatherBuffers) {
+        size_t batch = std::min(count - first, kMaxGatherBuffers);
+        size_t expected = unreadBytes(buffers + first, batch);
+
+        ssize_t result = gatherWrite(fd, buffers + first, batch);
+        if (result < 0) {
+            return total ? total : result;
+        }
+
+        total += result;
+
+        if (static_cast<size_t>(result) < expected) {
+            break;
+        }
+    }
+
+    return total;
+}
+
+}  // namespace anh
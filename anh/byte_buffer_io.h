@@ -0,0 +1,95 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#ifndef ANH_BYTE_BUFFER_IO_H_
+#define ANH_BYTE_BUFFER_IO_H_
+
+#include <cstdint>
+
+#include <sys/types.h>
+
+#include <boost/asio/buffer.hpp>
+
+#include "anh/byte_buffer.h"
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+/**
+ * Wraps the unread part of a buffer, from the read position to the end, for
+ * use with Boost.Asio write operations. Call ByteBuffer::readPosition to
+ * consume the bytes once they have been sent.
+ *
+ * \code
+ * size_t sent = socket.send(anh::readableBuffer(buffer));
+ * buffer.readPosition(buffer.readPosition() + sent);
+ * \endcode
+ *
+ * \returns A view of the readable region, valid until the buffer is next modified.
+ */
+inline boost::asio::const_buffers_1 readableBuffer(const ByteBuffer& buffer) {
+    return boost::asio::const_buffers_1(buffer.data() + buffer.readPosition(),
+        buffer.size() - buffer.readPosition());
+}
+
+/**
+ * Makes room for length bytes at the end of a buffer and wraps them for use
+ * with Boost.Asio read operations, so data is received straight into the
+ * buffer's storage. Call ByteBuffer::commit with the number of bytes received.
+ *
+ * \code
+ * size_t received = socket.receive(anh::writableBuffer(buffer, 4096));
+ * buffer.commit(received);
+ * \endcode
+ *
+ * \param length The number of bytes to make room for.
+ * \returns A view of the spare region, valid until the buffer is next modified.
+ */
+inline boost::asio::mutable_buffers_1 writableBuffer(ByteBuffer& buffer, size_t length) {
+    return boost::asio::mutable_buffers_1(buffer.prepare(length), length);
+}
+
+/**
+ * Reads whatever is available from a file descriptor onto the end of a buffer.
+ *
+ * The read goes straight into the buffer's spare capacity. A single readv also
+ * fills a per-thread overflow area so a large burst is drained in one call without
+ * growing the buffer up front; only bytes landing there are copied.
+ *
+ * \param fd The descriptor to read from.
+ * \param buffer The buffer to append to.
+ * \returns The number of bytes read, 0 at end of stream or -1 with errno set,
+ *      as with read(2).
+ */
+ssize_t readFrom(int fd, ByteBuffer& buffer);
+
+/**
+ * Writes the unread part of a buffer to a file descriptor and advances the
+ * read position past the bytes written.
+ *
+ * \param fd The descriptor to write to.
+ * \param buffer The buffer to send.
+ * \returns The number of bytes written or -1 with errno set, as with write(2).
+ */
+ssize_t writeTo(int fd, ByteBuffer& buffer);
+
+/**
+ * Writes the unread parts of several buffers with writev, advancing each
+ * buffer's read position past the bytes written from it.
+ *
+ * Up to 64 buffers are gathered per writev. Longer lists are written in
+ * batches, stopping early if a batch is only partly written.
+ *
+ * \param fd The descriptor to write to.
+ * \param buffers The buffers to send, in order.
+ * \param count The number of buffers.
+ * \returns The number of bytes written or -1 with errno set, as with writev(2).
+ *      An error after some bytes were written returns the bytes written.
+ */
+ssize_t writeTo(int fd, ByteBuffer* const* buffers, size_t count);
+
+}  // namespace anh
+
+#endif  // ANH_BYTE_BUFFER_IO_H_
@@ -0,0 +1,185 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/byte_buffer_io.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/local/connect_pair.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+
+#include <gtest/gtest.h>
+
+using anh::ByteBuffer;
+
+// Wrapping tests in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+class SocketPair {
+public:
+    SocketPair() {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            fds[0] = fds[1] = -1;
+        }
+
+        first = fds[0];
+        second = fds[1];
+    }
+
+    ~SocketPair() {
+        close(first);
+        close(second);
+    }
+
+    int first;
+    int second;
+};
+
+ByteBuffer makePayload(size_t size) {
+    ByteBuffer payload;
+    for (size_t i = 0; i < size; ++i) {
+        payload.write<uint8_t>(static_cast<uint8_t>(i * 7));
+    }
+
+    return payload;
+}
+
+TEST(ByteBufferIoTests, PrepareAndCommitAppendInPlace)
+{
+    ByteBuffer buffer;
+    buffer.write<uint32_t>(1);
+
+    unsigned char* region = buffer.prepare(128);
+    EXPECT_LE(size_t(4 + 128), buffer.capacity());
+    EXPECT_EQ(size_t(4), buffer.size());
+
+    std::memset(region, 0xAB, 128);
+    buffer.commit(128);
+
+    EXPECT_EQ(size_t(4 + 128), buffer.size());
+    EXPECT_EQ(buffer.size(), buffer.writePosition());
+    EXPECT_EQ(uint32_t(1), buffer.read<uint32_t>());
+    EXPECT_EQ(0xAB, buffer.read<uint8_t>());
+
+    EXPECT_THROW(buffer.commit(buffer.capacity()), std::out_of_range);
+}
+
+TEST(ByteBufferIoTests, ReadFromWritesDirectlyIntoSpareCapacity)
+{
+    SocketPair sockets;
+    ASSERT_LE(0, sockets.first);
+
+    ByteBuffer payload = makePayload(2048);
+    ASSERT_EQ(ssize_t(2048), anh::writeTo(sockets.first, payload));
+    EXPECT_EQ(payload.size(), payload.readPosition());
+
+    ByteBuffer received;
+    received.reserve(8192);
+    const unsigned char* storage = received.data();
+
+    ASSERT_EQ(ssize_t(2048), anh::readFrom(sockets.second, received));
+
+    // The storage did not move, so the bytes were read straight into it.
+    EXPECT_EQ(storage, received.data());
+    ASSERT_EQ(payload.size(), received.size());
+    EXPECT_EQ(0, memcmp(payload.data(), received.data(), payload.size()));
+}
+
+TEST(ByteBufferIoTests, ReadFromDrainsMoreThanTheSpareCapacity)
+{
+    SocketPair sockets;
+    ASSERT_LE(0, sockets.first);
+
+    ByteBuffer payload = makePayload(16384);
+    ASSERT_EQ(ssize_t(16384), anh::writeTo(sockets.first, payload));
+
+    ByteBuffer received;
+    size_t total = 0;
+    while (total < payload.size()) {
+        ssize_t result = anh::readFrom(sockets.second, received);
+        ASSERT_LT(0, result);
+        total += result;
+    }
+
+    ASSERT_EQ(payload.size(), received.size());
+    EXPECT_EQ(0, memcmp(payload.data(), received.data(), payload.size()));
+}
+
+TEST(ByteBufferIoTests, WriteToGathersSeveralBuffers)
+{
+    SocketPair sockets;
+    ASSERT_LE(0, sockets.first);
+
+    ByteBuffer header;
+    header.write<uint32_t>(0xCAFEBABE);
+    header.read<uint8_t>();
+
+    ByteBuffer body = makePayload(100);
+
+    ByteBuffer* buffers[] = { &header, &body };
+    ASSERT_EQ(ssize_t(3 + 100), anh::writeTo(sockets.first, buffers, 2));
+    EXPECT_EQ(header.size(), header.readPosition());
+    EXPECT_EQ(body.size(), body.readPosition());
+
+    ByteBuffer received;
+    ASSERT_EQ(ssize_t(3 + 100), anh::readFrom(sockets.second, received));
+    EXPECT_EQ(0, memcmp(header.data() + 1, received.data(), 3));
+    EXPECT_EQ(0, memcmp(body.data(), received.data() + 3, 100));
+}
+
+TEST(ByteBufferIoTests, WriteToSendsMoreBuffersThanOneGather)
+{
+    SocketPair sockets;
+    ASSERT_LE(0, sockets.first);
+
+    std::vector<ByteBuffer> bodies(150);
+    std::vector<ByteBuffer*> buffers;
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        bodies[i].write<uint16_t>(static_cast<uint16_t>(i));
+        buffers.push_back(&bodies[i]);
+    }
+
+    ASSERT_EQ(ssize_t(150 * 2), anh::writeTo(sockets.first, buffers.data(), buffers.size()));
+    EXPECT_EQ(bodies.back().size(), bodies.back().readPosition());
+
+    ByteBuffer received;
+    ASSERT_EQ(ssize_t(150 * 2), anh::readFrom(sockets.second, received));
+    for (size_t i = 0; i < bodies.size(); ++i) {
+        EXPECT_EQ(i, received.read<uint16_t>());
+    }
+}
+
+TEST(ByteBufferIoTests, AsioBuffersCoverReadableAndWritableRegions)
+{
+    boost::asio::io_service io_service;
+    boost::asio::local::stream_protocol::socket writer(io_service);
+    boost::asio::local::stream_protocol::socket reader(io_service);
+    boost::asio::local::connect_pair(writer, reader);
+
+    ByteBuffer payload = makePayload(4096);
+    payload.read<uint32_t>();
+
+    size_t sent = boost::asio::write(writer, anh::readableBuffer(payload));
+    EXPECT_EQ(payload.size() - sizeof(uint32_t), sent);
+
+    ByteBuffer received;
+    boost::asio::mutable_buffers_1 region = anh::writableBuffer(received, sent);
+    const unsigned char* storage = received.data();
+
+    size_t read = boost::asio::read(reader, region);
+    received.commit(read);
+
+    EXPECT_EQ(storage, received.data());
+    ASSERT_EQ(sent, received.size());
+    EXPECT_EQ(0, memcmp(payload.data() + sizeof(uint32_t), received.data(), sent));
+}
+
+}  // namespace
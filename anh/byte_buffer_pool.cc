@@ -0,0 +1,258 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/byte_buffer_pool.h"
+
+#include <cassert>
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+namespace {
+
+// Capacities reserved for each size class, smallest first. Anything larger
+// than the last class is allocated to fit and freed when it is released, so
+// one huge message cannot pin its memory in the pool.
+const size_t kSizeClasses[ByteBufferPool::SIZE_CLASS_COUNT] = {
+    64, 256, 1024, 4096, 16384, 65536
+};
+
+// Number of idle buffers each thread keeps per size class before handing
+// extras back to the shared depot.
+const size_t kThreadCacheLimit = 16;
+
+// Returns the smallest size class that can hold size bytes, or
+// SIZE_CLASS_COUNT if the request is larger than every class.
+size_t sizeClassForRequest(size_t size) {
+    size_t size_class = 0;
+    while (size_class < ByteBufferPool::SIZE_CLASS_COUNT && kSizeClasses[size_class] < size) {
+        ++size_class;
+    }
+
+    return size_class;
+}
+
+// Returns the largest size class a buffer with the given capacity can serve,
+// or SIZE_CLASS_COUNT if it is too small or too large to be pooled.
+size_t sizeClassForCapacity(size_t capacity) {
+    if (capacity > kSizeClasses[ByteBufferPool::SIZE_CLASS_COUNT - 1]) {
+        return ByteBufferPool::SIZE_CLASS_COUNT;
+    }
+
+    size_t size_class = ByteBufferPool::SIZE_CLASS_COUNT;
+    while (size_class > 0 && kSizeClasses[size_class - 1] > capacity) {
+        --size_class;
+    }
+
+    return (size_class == 0) ? static_cast<size_t>(ByteBufferPool::SIZE_CLASS_COUNT) : size_class - 1;
+}
+
+}  // namespace
+
+struct ByteBufferPool::ThreadCache {
+    explicit ThreadCache(ByteBufferPool* owner)
+        : pool(owner) {
+        for (size_t i = 0; i < SIZE_CLASS_COUNT; ++i) {
+            buffers[i].reserve(kThreadCacheLimit);
+        }
+    }
+
+    // When a thread exits its idle buffers go back to the shared depot so
+    // other threads can pick them up.
+    ~ThreadCache() {
+        for (size_t i = 0; i < SIZE_CLASS_COUNT; ++i) {
+            for (size_t j = 0; j < buffers[i].size(); ++j) {
+                pool->depositToDepot(i, buffers[i][j]);
+            }
+        }
+    }
+
+    ByteBufferPool* pool;
+    std::vector<ByteBuffer*> buffers[SIZE_CLASS_COUNT];
+};
+
+PooledByteBuffer::PooledByteBuffer()
+    : pool_(nullptr)
+    , buffer_(nullptr) {}
+
+PooledByteBuffer::PooledByteBuffer(ByteBufferPool* pool, ByteBuffer* buffer)
+    : pool_(pool)
+    , buffer_(buffer) {}
+
+PooledByteBuffer::PooledByteBuffer(PooledByteBuffer&& other)
+    : pool_(other.pool_)
+    , buffer_(other.buffer_) {
+    other.pool_ = nullptr;
+    other.buffer_ = nullptr;
+}
+
+PooledByteBuffer& PooledByteBuffer::operator=(PooledByteBuffer&& other) {
+    if (this != &other) {
+        release();
+
+        pool_ = other.pool_;
+        buffer_ = other.buffer_;
+
+        other.pool_ = nullptr;
+        other.buffer_ = nullptr;
+    }
+
+    return *this;
+}
+
+PooledByteBuffer::~PooledByteBuffer() {
+    release();
+}
+
+ByteBuffer& PooledByteBuffer::operator*() const {
+    assert(buffer_ && "Dereferencing an empty PooledByteBuffer");
+    return *buffer_;
+}
+
+ByteBuffer* PooledByteBuffer::operator->() const {
+    assert(buffer_ && "Dereferencing an empty PooledByteBuffer");
+    return buffer_;
+}
+
+ByteBuffer* PooledByteBuffer::get() const {
+    return buffer_;
+}
+
+void PooledByteBuffer::release() {
+    if (buffer_) {
+        pool_->recycle(buffer_);
+    }
+
+    pool_ = nullptr;
+    buffer_ = nullptr;
+}
+
+double ByteBufferPoolStats::hit_rate() const {
+    if (acquires == 0) {
+        return 0.0;
+    }
+
+    return static_cast<double>(hits) / static_cast<double>(acquires);
+}
+
+ByteBufferPool::ByteBufferPool(size_t max_cached_per_class)
+    : max_cached_per_class_(max_cached_per_class) {
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; ++i) {
+        depot_size_[i].store(0);
+    }
+
+    acquires_.store(0);
+    hits_.store(0);
+    allocations_.store(0);
+    discards_.store(0);
+}
+
+ByteBufferPool::~ByteBufferPool() {
+    // Flush the calling thread's cache into the depot, then free everything.
+    thread_cache_.reset();
+
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; ++i) {
+        ByteBuffer* buffer = nullptr;
+        while (depot_[i].try_pop(buffer)) {
+            delete buffer;
+        }
+    }
+}
+
+PooledByteBuffer ByteBufferPool::acquire(size_t size_hint) {
+    acquires_.fetch_add(1, std::memory_order_relaxed);
+
+    size_t size_class = sizeClassForRequest(size_hint);
+
+    if (size_class < SIZE_CLASS_COUNT) {
+        std::vector<ByteBuffer*>& cached = threadCache().buffers[size_class];
+
+        if (!cached.empty()) {
+            ByteBuffer* buffer = cached.back();
+            cached.pop_back();
+
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return PooledByteBuffer(this, buffer);
+        }
+
+        ByteBuffer* buffer = nullptr;
+        if (depot_[size_class].try_pop(buffer)) {
+            depot_size_[size_class].fetch_sub(1, std::memory_order_relaxed);
+
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return PooledByteBuffer(this, buffer);
+        }
+    }
+
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+
+    ByteBuffer* buffer = new ByteBuffer();
+    buffer->reserve((size_class < SIZE_CLASS_COUNT) ? kSizeClasses[size_class] : size_hint);
+
+    return PooledByteBuffer(this, buffer);
+}
+
+ByteBufferPoolStats ByteBufferPool::stats() const {
+    ByteBufferPoolStats stats;
+    stats.acquires = acquires_.load(std::memory_order_relaxed);
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.allocations = allocations_.load(std::memory_order_relaxed);
+    stats.discards = discards_.load(std::memory_order_relaxed);
+
+    return stats;
+}
+
+size_t ByteBufferPool::sizeClassCapacity(size_t size) {
+    size_t size_class = sizeClassForRequest(size);
+    return (size_class < SIZE_CLASS_COUNT) ? kSizeClasses[size_class] : size;
+}
+
+void ByteBufferPool::recycle(ByteBuffer* buffer) {
+    buffer->clear();
+
+    // Buffers may have grown while in use, so file them under the largest
+    // class their current capacity can serve.
+    size_t size_class = sizeClassForCapacity(buffer->capacity());
+
+    if (size_class == SIZE_CLASS_COUNT) {
+        discards_.fetch_add(1, std::memory_order_relaxed);
+        delete buffer;
+        return;
+    }
+
+    std::vector<ByteBuffer*>& cached = threadCache().buffers[size_class];
+
+    if (cached.size() < kThreadCacheLimit) {
+        cached.push_back(buffer);
+        return;
+    }
+
+    depositToDepot(size_class, buffer);
+}
+
+void ByteBufferPool::depositToDepot(size_t size_class, ByteBuffer* buffer) {
+    if (depot_size_[size_class].fetch_add(1, std::memory_order_relaxed) >= max_cached_per_class_) {
+        depot_size_[size_class].fetch_sub(1, std::memory_order_relaxed);
+
+        discards_.fetch_add(1, std::memory_order_relaxed);
+        delete buffer;
+        return;
+    }
+
+    depot_[size_class].push(buffer);
+}
+
+ByteBufferPool::ThreadCache& ByteBufferPool::threadCache() {
+    ThreadCache* cache = thread_cache_.get();
+
+    if (!cache) {
+        cache = new ThreadCache(this);
+        thread_cache_.reset(cache);
+    }
+
+    return *cache;
+}
+
+}  // namespace anh
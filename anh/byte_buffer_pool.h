@@ -0,0 +1,151 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#ifndef ANH_BYTE_BUFFER_POOL_H_
+#define ANH_BYTE_BUFFER_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include <boost/thread/tss.hpp>
+#include <tbb/concurrent_queue.h>
+
+#include "anh/byte_buffer.h"
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+class ByteBufferPool;
+
+/*! \brief An RAII handle to a ByteBuffer borrowed from a ByteBufferPool.
+ *
+ * The buffer is cleared and handed back to its pool when the handle is
+ * destroyed or release() is called. Handles can be moved but not copied.
+ */
+class PooledByteBuffer {
+public:
+    /// Creates an empty handle that does not own a buffer.
+    PooledByteBuffer();
+    PooledByteBuffer(ByteBufferPool* pool, ByteBuffer* buffer);
+    PooledByteBuffer(PooledByteBuffer&& other);
+    PooledByteBuffer& operator=(PooledByteBuffer&& other);
+
+    /// Returns the buffer to its pool, if the handle still owns one.
+    ~PooledByteBuffer();
+
+    ByteBuffer& operator*() const;
+    ByteBuffer* operator->() const;
+    ByteBuffer* get() const;
+
+    /// Returns the buffer to its pool early, leaving the handle empty.
+    void release();
+
+private:
+    /// Disable copying, a buffer can only have one owner.
+    PooledByteBuffer(const PooledByteBuffer&);
+    PooledByteBuffer& operator=(const PooledByteBuffer&);
+
+    ByteBufferPool* pool_;
+    ByteBuffer* buffer_;
+};
+
+/*! \brief Counters describing how well a ByteBufferPool is recycling buffers.
+ */
+struct ByteBufferPoolStats {
+    uint64_t acquires;     ///< Total number of buffers handed out.
+    uint64_t hits;         ///< Acquires satisfied by a recycled buffer.
+    uint64_t allocations;  ///< Acquires that had to allocate a new buffer.
+    uint64_t discards;     ///< Released buffers freed because the pool was full
+                           ///< or they outgrew the largest size class.
+
+    /// \returns The fraction of acquires satisfied without allocating.
+    double hit_rate() const;
+};
+
+/*! \brief Hands out pre-reserved ByteBuffers bucketed by size class and takes
+ * them back for reuse, so steady-state serialization does not allocate.
+ *
+ * Each thread keeps a small private cache per size class and only touches the
+ * shared depot when that cache runs dry or overflows.
+ *
+ * \code
+ * anh::ByteBufferPool pool;
+ *
+ * anh::PooledByteBuffer buffer = pool.acquire(256);
+ * some_event->serialize(*buffer);
+ *
+ * ... // The buffer returns to the pool when it goes out of scope.
+ * \endcode
+ *
+ * \note The pool must outlive every thread that acquires buffers from it.
+ */
+class ByteBufferPool {
+public:
+    /// The number of distinct size classes buffers are bucketed into.
+    enum { SIZE_CLASS_COUNT = 6 };
+
+    /**
+     * \param max_cached_per_class The maximum number of idle buffers the shared
+     *      depot keeps for each size class before freeing released buffers.
+     */
+    explicit ByteBufferPool(size_t max_cached_per_class = 64);
+    ~ByteBufferPool();
+
+    /**
+     * Borrows a buffer with at least the requested capacity reserved.
+     *
+     * \param size_hint The number of bytes the caller expects to write.
+     * \returns A handle that returns the buffer to the pool when destroyed.
+     */
+    PooledByteBuffer acquire(size_t size_hint = 0);
+
+    /// \returns A snapshot of the pool's recycling counters.
+    ByteBufferPoolStats stats() const;
+
+    /**
+     * \param size The number of bytes requested.
+     * \returns The capacity reserved for buffers serving the request.
+     */
+    static size_t sizeClassCapacity(size_t size);
+
+private:
+    friend class PooledByteBuffer;
+
+    struct ThreadCache;
+    typedef tbb::concurrent_queue<ByteBuffer*> BufferQueue;
+
+    /// Disable copying, the pool owns every buffer it has handed out.
+    ByteBufferPool(const ByteBufferPool&);
+    ByteBufferPool& operator=(const ByteBufferPool&);
+
+    void recycle(ByteBuffer* buffer);
+    void depositToDepot(size_t size_class, ByteBuffer* buffer);
+    ThreadCache& threadCache();
+
+    size_t max_cached_per_class_;
+
+    BufferQueue depot_[SIZE_CLASS_COUNT];
+    std::atomic<size_t> depot_size_[SIZE_CLASS_COUNT];
+
+    // Win32 complains about stl during linkage, disable the warning.
+#ifdef _WIN32
+#pragma warning (disable : 4251)
+#endif
+    boost::thread_specific_ptr<ThreadCache> thread_cache_;
+    // Re-enable the warning.
+#ifdef _WIN32
+#pragma warning (default : 4251)
+#endif
+
+    std::atomic<uint64_t> acquires_;
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> allocations_;
+    std::atomic<uint64_t> discards_;
+};
+
+}  // namespace anh
+
+#endif  // ANH_BYTE_BUFFER_POOL_H_
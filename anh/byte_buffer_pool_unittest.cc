@@ -0,0 +1,145 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/byte_buffer_pool.h"
+
+#include <boost/thread.hpp>
+#include <gtest/gtest.h>
+
+using anh::ByteBuffer;
+using anh::ByteBufferPool;
+using anh::ByteBufferPoolStats;
+using anh::PooledByteBuffer;
+
+// Wrapping tests in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+TEST(ByteBufferPoolTests, AcquiredBufferIsEmptyAndReserved)
+{
+    ByteBufferPool pool;
+    PooledByteBuffer buffer = pool.acquire(100);
+
+    EXPECT_EQ(uint32_t(0), buffer->size());
+    EXPECT_LE(size_t(100), buffer->capacity());
+    EXPECT_EQ(ByteBufferPool::sizeClassCapacity(100), buffer->capacity());
+}
+
+TEST(ByteBufferPoolTests, ReleasedBufferIsReused)
+{
+    ByteBufferPool pool;
+    const ByteBuffer* first = nullptr;
+
+    {
+        PooledByteBuffer buffer = pool.acquire(32);
+        buffer->write<int>(10);
+        first = buffer.get();
+    }
+
+    PooledByteBuffer buffer = pool.acquire(32);
+    EXPECT_EQ(first, buffer.get());
+    EXPECT_EQ(uint32_t(0), buffer->size());
+    EXPECT_EQ(uint32_t(0), buffer->writePosition());
+}
+
+TEST(ByteBufferPoolTests, SteadyStateDoesNotAllocate)
+{
+    ByteBufferPool pool;
+
+    for (int i = 0; i < 1000; ++i) {
+        PooledByteBuffer buffer = pool.acquire(48);
+        buffer->write<uint32_t>(i);
+        buffer->write<uint64_t>(i);
+    }
+
+    ByteBufferPoolStats stats = pool.stats();
+    EXPECT_EQ(uint64_t(1000), stats.acquires);
+    EXPECT_EQ(uint64_t(1), stats.allocations);
+    EXPECT_EQ(uint64_t(999), stats.hits);
+    EXPECT_DOUBLE_EQ(0.999, stats.hit_rate());
+}
+
+TEST(ByteBufferPoolTests, GrownBufferIsRecycledIntoLargerClass)
+{
+    ByteBufferPool pool;
+    const ByteBuffer* grown = nullptr;
+
+    {
+        PooledByteBuffer buffer = pool.acquire(16);
+        for (int i = 0; i < 300; ++i) {
+            buffer->write<uint8_t>(0);
+        }
+        grown = buffer.get();
+    }
+
+    PooledByteBuffer buffer = pool.acquire(256);
+    EXPECT_EQ(grown, buffer.get());
+}
+
+TEST(ByteBufferPoolTests, OversizedBufferIsDiscarded)
+{
+    ByteBufferPool pool;
+    const size_t largest = ByteBufferPool::sizeClassCapacity(65536);
+
+    {
+        PooledByteBuffer buffer = pool.acquire(largest * 4);
+        EXPECT_LE(largest * 4, buffer->capacity());
+    }
+
+    EXPECT_EQ(uint64_t(1), pool.stats().discards);
+
+    {
+        PooledByteBuffer buffer = pool.acquire(16);
+        for (size_t i = 0; i <= largest; ++i) {
+            buffer->write<uint8_t>(0);
+        }
+    }
+
+    EXPECT_EQ(uint64_t(2), pool.stats().discards);
+
+    PooledByteBuffer buffer = pool.acquire(largest);
+    EXPECT_EQ(uint64_t(3), pool.stats().allocations);
+}
+
+TEST(ByteBufferPoolTests, MovingHandleTransfersOwnership)
+{
+    ByteBufferPool pool;
+
+    PooledByteBuffer first = pool.acquire();
+    ByteBuffer* raw = first.get();
+
+    PooledByteBuffer second(std::move(first));
+    EXPECT_EQ(nullptr, first.get());
+    EXPECT_EQ(raw, second.get());
+
+    second.release();
+    EXPECT_EQ(nullptr, second.get());
+
+    PooledByteBuffer third = pool.acquire();
+    EXPECT_EQ(raw, third.get());
+}
+
+TEST(ByteBufferPoolTests, BuffersCanBeSharedAcrossThreads)
+{
+    ByteBufferPool pool;
+    boost::thread_group threads;
+
+    for (int t = 0; t < 4; ++t) {
+        threads.create_thread([&pool] () {
+            for (int i = 0; i < 500; ++i) {
+                PooledByteBuffer buffer = pool.acquire(128);
+                buffer->write<int>(i);
+                EXPECT_EQ(i, buffer->read<int>());
+            }
+        });
+    }
+
+    threads.join_all();
+
+    ByteBufferPoolStats stats = pool.stats();
+    EXPECT_EQ(uint64_t(2000), stats.acquires);
+    EXPECT_EQ(stats.acquires, stats.hits + stats.allocations);
+    EXPECT_GE(uint64_t(4), stats.allocations);
+}
+
+}  // namespace
@@ -4,6 +4,8 @@
 
 #include "anh/byte_buffer.h"
 
+#include <algorithm>
+#include <vector>
 #include <gtest/gtest.h>
 
 using anh::ByteBuffer;
@@ -17,10 +19,10 @@ TEST(ByteBufferTests, ByteBufferIsEmptyWhenCreated)
     EXPECT_EQ(uint32_t(0), buffer.size());
 }
 
-TEST(ByteBufferTests, ByteBufferDefaultCapacityIsZero)
+TEST(ByteBufferTests, ByteBufferDefaultCapacityIsInlineCapacity)
 {
     ByteBuffer buffer;
-    EXPECT_EQ(uint32_t(0), buffer.capacity());
+    EXPECT_EQ(size_t(ByteBuffer::INLINE_CAPACITY), buffer.capacity());
 }
 
 TEST(ByteBufferTests, WritingIntReportsCorrectSizeAndCapacity)
@@ -29,7 +31,7 @@ TEST(ByteBufferTests, WritingIntReportsCorrectSizeAndCapacity)
     buffer.write<int>(10);
 
     EXPECT_EQ(uint32_t(4), buffer.size());
-    EXPECT_EQ(uint32_t(4), buffer.capacity());
+    EXPECT_EQ(size_t(ByteBuffer::INLINE_CAPACITY), buffer.capacity());
 }
 
 TEST(ByteBufferTests, WritingTwoIntsReportsCorrectSizeAndCapacity)
@@ -38,11 +40,96 @@ TEST(ByteBufferTests, WritingTwoIntsReportsCorrectSizeAndCapacity)
 
     buffer.write<int>(10);
     EXPECT_EQ(uint32_t(4), buffer.size());
-    EXPECT_EQ(uint32_t(4), buffer.capacity());
+    EXPECT_EQ(size_t(ByteBuffer::INLINE_CAPACITY), buffer.capacity());
 
     buffer.write<int>(20);
     EXPECT_EQ(uint32_t(8), buffer.size());
-    EXPECT_EQ(uint32_t(8), buffer.capacity());
+    EXPECT_EQ(size_t(ByteBuffer::INLINE_CAPACITY), buffer.capacity());
+}
+
+TEST(ByteBufferTests, OutgrowingInlineCapacityMovesDataToTheHeap)
+{
+    ByteBuffer buffer;
+
+    for (uint32_t i = 0; i < ByteBuffer::INLINE_CAPACITY; ++i) {
+        buffer.write<uint32_t>(i);
+    }
+
+    EXPECT_FALSE(buffer.raw().is_inline());
+    EXPECT_LE(size_t(ByteBuffer::INLINE_CAPACITY * sizeof(uint32_t)), buffer.capacity());
+
+    for (uint32_t i = 0; i < ByteBuffer::INLINE_CAPACITY; ++i) {
+        EXPECT_EQ(i, buffer.read<uint32_t>());
+    }
+}
+
+TEST(ByteBufferTests, CopyingAndSwappingKeepsInlineAndHeapContents)
+{
+    ByteBuffer small;
+    small.write<uint32_t>(0xDEADBEEF);
+
+    ByteBuffer large;
+    for (uint32_t i = 0; i < ByteBuffer::INLINE_CAPACITY; ++i) {
+        large.write<uint32_t>(i);
+    }
+
+    ByteBuffer small_copy(small);
+    ByteBuffer large_copy(large);
+    EXPECT_TRUE(small_copy.raw().is_inline());
+    EXPECT_FALSE(large_copy.raw().is_inline());
+
+    small_copy.swap(large_copy);
+    EXPECT_FALSE(small_copy.raw().is_inline());
+    EXPECT_TRUE(large_copy.raw().is_inline());
+
+    EXPECT_EQ(0xDEADBEEF, large_copy.read<uint32_t>());
+    ASSERT_EQ(large.size(), small_copy.size());
+    EXPECT_EQ(0, memcmp(large.data(), small_copy.data(), large.size()));
+}
+
+TEST(ByteBufferTests, MovingTakesHeapStorageAndPositions)
+{
+    ByteBuffer large;
+    for (uint32_t i = 0; i < ByteBuffer::INLINE_CAPACITY; ++i) {
+        large.write<uint32_t>(i);
+    }
+    large.read<uint32_t>();
+
+    const unsigned char* storage = large.data();
+    size_t size = large.size();
+
+    ByteBuffer moved(std::move(large));
+    EXPECT_EQ(storage, moved.data());
+    EXPECT_EQ(size, moved.size());
+    EXPECT_EQ(sizeof(uint32_t), moved.readPosition());
+    EXPECT_EQ(size, moved.writePosition());
+    EXPECT_EQ(uint32_t(0), large.size());
+    EXPECT_EQ(uint32_t(0), large.readPosition());
+
+    ByteBuffer small;
+    small.write<uint32_t>(0xDEADBEEF);
+
+    small = std::move(moved);
+    EXPECT_EQ(storage, small.data());
+    EXPECT_EQ(uint32_t(1), small.read<uint32_t>());
+    EXPECT_EQ(uint32_t(0), moved.size());
+
+    moved.write<uint16_t>(7);
+    EXPECT_EQ(7, moved.read<uint16_t>());
+}
+
+TEST(ByteBufferTests, VectorCopiesTheContents)
+{
+    ByteBuffer buffer;
+    buffer.write<uint16_t>(0x0102);
+    buffer.write<uint8_t>(3);
+
+    std::vector<unsigned char> contents = buffer.vector();
+    ASSERT_EQ(buffer.size(), contents.size());
+    EXPECT_EQ(0, memcmp(buffer.data(), contents.data(), contents.size()));
+
+    contents[0] = 0xFF;
+    EXPECT_NE(0xFF, buffer.data()[0]);
 }
 
 TEST(ByteBufferTests, CanReadIntWrittenToTheBuffer)
@@ -76,12 +163,12 @@ TEST(ByteBufferTests, WritingStringReportsCorrectSizeAndCapacity)
 {
     ByteBuffer buffer;
     EXPECT_EQ(uint32_t(0), buffer.size());
-    EXPECT_EQ(uint32_t(0), buffer.capacity());
+    EXPECT_EQ(size_t(ByteBuffer::INLINE_CAPACITY), buffer.capacity());
 
     buffer.write<std::string>(std::string("test string"));
 
     EXPECT_EQ(uint32_t(13), buffer.size());
-    EXPECT_EQ(uint32_t(13), buffer.capacity());
+    EXPECT_EQ(size_t(ByteBuffer::INLINE_CAPACITY), buffer.capacity());
 }
 
 TEST(ByteBufferTests, CanReadStringWrittenToTheBuffer)
@@ -111,13 +198,13 @@ TEST(ByteBufferTests, WritingUnicodeStringReportsCorrectSizeAndCapacity)
 {
     ByteBuffer buffer;
     EXPECT_EQ(uint32_t(0), buffer.size());
-    EXPECT_EQ(uint32_t(0), buffer.capacity());
+    EXPECT_EQ(size_t(ByteBuffer::INLINE_CAPACITY), buffer.capacity());
 
     buffer.write<std::wstring>(std::wstring(L"test string"));
 
-    // Length and Capacity should be size of int + size of string * size of wchar_t.
+    // Length should be size of int + size of string * size of a UTF-16 character.
     EXPECT_EQ(sizeof(uint32_t) + (11 * 2), buffer.size());
-    EXPECT_EQ(sizeof(uint32_t) + (11 * 2), buffer.capacity());
+    EXPECT_EQ(size_t(ByteBuffer::INLINE_CAPACITY), buffer.capacity());
 }
 
 TEST(ByteBufferTests, CanReadUnicodeStringWrittenToTheBuffer)
@@ -228,6 +315,26 @@ TEST(ByteBufferTests, CanWriteAtOffset)
     EXPECT_EQ(3532, buffer.peekAt<int>(4));
 }
 
+TEST(ByteBufferTests, WriteAtOverwritesInPlace)
+{
+    ByteBuffer buffer;
+    buffer.write<uint32_t>(0);
+    for (int i = 0; i < 1000; ++i) {
+        buffer.write<uint32_t>(i);
+    }
+
+    const unsigned char* storage = buffer.data();
+    size_t size = buffer.size();
+
+    buffer.writeAt<uint32_t>(0, 1000);
+
+    EXPECT_EQ(storage, buffer.data());
+    EXPECT_EQ(size, buffer.size());
+    EXPECT_EQ(size, buffer.writePosition());
+    EXPECT_EQ(uint32_t(1000), buffer.peekAt<uint32_t>(0));
+    EXPECT_EQ(uint32_t(0), buffer.peekAt<uint32_t>(4));
+}
+
 TEST(ByteBufferTests, CanAppendBuffers)
 {
     ByteBuffer buffer1;
@@ -271,4 +378,374 @@ TEST(ByteBufferTests, CanSwapEndian)
     EXPECT_EQ(uint64_t(2), buffer.peek<uint64_t>(true));
 }
 
+TEST(ByteBufferTests, CanSwapEndianOfFloatingPointValues)
+{
+    ByteBuffer buffer;
+    float value = 12.5f;
+
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+    for (int i = sizeof(float) - 1; i >= 0; --i) {
+        buffer.write<unsigned char>(bytes[i]);
+    }
+
+    EXPECT_EQ(value, buffer.peek<float>(true));
+}
+
+TEST(ByteBufferTests, SmallVarintsUseOneByte)
+{
+    ByteBuffer buffer;
+    buffer.writeVarint<uint64_t>(0);
+    buffer.writeVarint<uint64_t>(127);
+
+    EXPECT_EQ(uint32_t(2), buffer.size());
+    EXPECT_EQ(uint64_t(0), buffer.readVarint<uint64_t>());
+    EXPECT_EQ(uint64_t(127), buffer.readVarint<uint64_t>());
+}
+
+TEST(ByteBufferTests, VarintIsEncodedAsLeb128)
+{
+    ByteBuffer buffer;
+    buffer.writeVarint<uint32_t>(300);
+
+    EXPECT_EQ(uint32_t(2), buffer.size());
+    EXPECT_EQ(0xAC, buffer.read<uint8_t>());
+    EXPECT_EQ(0x02, buffer.read<uint8_t>());
+}
+
+TEST(ByteBufferTests, CanReadVarintsOfEveryLength)
+{
+    ByteBuffer buffer;
+
+    for (int shift = 0; shift < 64; ++shift) {
+        buffer.writeVarint<uint64_t>(uint64_t(1) << shift);
+        buffer.writeVarint<uint64_t>((uint64_t(1) << shift) - 1);
+    }
+    buffer.writeVarint<uint64_t>(UINT64_MAX);
+
+    for (int shift = 0; shift < 64; ++shift) {
+        EXPECT_EQ(uint64_t(1) << shift, buffer.readVarint<uint64_t>());
+        EXPECT_EQ((uint64_t(1) << shift) - 1, buffer.readVarint<uint64_t>());
+    }
+    EXPECT_EQ(UINT64_MAX, buffer.readVarint<uint64_t>());
+    EXPECT_EQ(buffer.size(), buffer.readPosition());
+}
+
+TEST(ByteBufferTests, SignedVarintsAreZigzagEncoded)
+{
+    ByteBuffer buffer;
+    buffer.writeVarint<int32_t>(-1);
+    buffer.writeVarint<int32_t>(1);
+    buffer.writeVarint<int64_t>(INT64_MIN);
+    buffer.writeVarint<int64_t>(INT64_MAX);
+
+    EXPECT_EQ(0x01, buffer.peekAt<uint8_t>(0));
+    EXPECT_EQ(0x02, buffer.peekAt<uint8_t>(1));
+
+    EXPECT_EQ(-1, buffer.readVarint<int32_t>());
+    EXPECT_EQ(1, buffer.readVarint<int32_t>());
+    EXPECT_EQ(INT64_MIN, buffer.readVarint<int64_t>());
+    EXPECT_EQ(INT64_MAX, buffer.readVarint<int64_t>());
+}
+
+TEST(ByteBufferTests, ReadingTruncatedVarintThrowsException)
+{
+    ByteBuffer buffer;
+    buffer.write<uint8_t>(0x80);
+    buffer.write<uint8_t>(0x80);
+
+    EXPECT_THROW(buffer.readVarint<uint64_t>(), std::out_of_range);
+    EXPECT_EQ(uint32_t(0), buffer.readPosition());
+}
+
+TEST(ByteBufferTests, ReadingVarintTooLargeForTypeThrowsException)
+{
+    ByteBuffer buffer;
+    buffer.writeVarint<uint32_t>(70000);
+    buffer.writeVarint<int32_t>(-70000);
+
+    EXPECT_THROW(buffer.readVarint<uint16_t>(), std::overflow_error);
+
+    buffer.readPosition(ByteBuffer::varintSize(70000));
+    EXPECT_THROW(buffer.readVarint<int16_t>(), std::overflow_error);
+}
+
+TEST(ByteBufferTests, ReadingVarintTooLargeForTypeLeavesPositionUnchanged)
+{
+    ByteBuffer buffer;
+    buffer.writeVarint<uint32_t>(300);
+    buffer.writeVarint<int32_t>(-300);
+
+    EXPECT_THROW(buffer.readVarint<uint8_t>(), std::overflow_error);
+    EXPECT_EQ(uint32_t(0), buffer.readPosition());
+    EXPECT_EQ(uint32_t(300), buffer.readVarint<uint32_t>());
+
+    size_t position = buffer.readPosition();
+    EXPECT_THROW(buffer.readVarint<int8_t>(), std::overflow_error);
+    EXPECT_EQ(position, buffer.readPosition());
+    EXPECT_EQ(-300, buffer.readVarint<int32_t>());
+}
+
+TEST(ByteBufferTests, ReadingOverlongVarintThrowsException)
+{
+    ByteBuffer buffer;
+    buffer.write<uint8_t>(0x80);
+    buffer.write<uint8_t>(0x00);
+
+    EXPECT_THROW(buffer.readVarint<uint64_t>(), std::runtime_error);
+    EXPECT_EQ(uint32_t(0), buffer.readPosition());
+
+    ByteBuffer longer;
+    longer.write<uint8_t>(0x81);
+    longer.write<uint8_t>(0x80);
+    longer.write<uint8_t>(0x00);
+
+    EXPECT_THROW(longer.readVarint<uint64_t>(), std::runtime_error);
+    EXPECT_EQ(uint32_t(0), longer.readPosition());
+}
+
+TEST(ByteBufferTests, CanReadArrayWrittenToTheBuffer)
+{
+    ByteBuffer buffer;
+    float positions[] = {1.0f, -2.5f, 3.25f, 1024.0f, -0.125f};
+
+    buffer.writeArray(positions, 5);
+    EXPECT_EQ(5 * sizeof(float), buffer.size());
+
+    float result[5];
+    buffer.readArray(result, 5);
+
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(positions[i], result[i]);
+    }
+    EXPECT_EQ(buffer.size(), buffer.readPosition());
+}
+
+TEST(ByteBufferTests, ReadingArrayPastBufferEndThrowsException)
+{
+    ByteBuffer buffer;
+    uint32_t values[] = {1, 2, 3};
+    buffer.writeArray(values, 3);
+
+    uint32_t result[4];
+    EXPECT_THROW(buffer.readArray(result, 4), std::out_of_range);
+    EXPECT_EQ(uint32_t(0), buffer.readPosition());
+}
+
+TEST(ByteBufferTests, ReadingArrayCanSwapEndian)
+{
+    // Use an odd count so both the vectorized body and the scalar tail run.
+    const size_t count = 1001;
+
+    std::vector<uint16_t> shorts(count);
+    std::vector<uint32_t> ints(count);
+    std::vector<uint64_t> longs(count);
+    for (size_t i = 0; i < count; ++i) {
+        shorts[i] = static_cast<uint16_t>(i * 251);
+        ints[i] = static_cast<uint32_t>(i * 2654435761u);
+        longs[i] = i * 0x9E3779B97F4A7C15ULL;
+    }
+
+    ByteBuffer buffer;
+    buffer.writeArray(&shorts[0], count);
+    buffer.writeArray(&ints[0], count);
+    buffer.writeArray(&longs[0], count);
+
+    // Swapping element by element gives the reference result.
+    std::vector<uint16_t> expected_shorts(count);
+    std::vector<uint32_t> expected_ints(count);
+    std::vector<uint64_t> expected_longs(count);
+    for (size_t i = 0; i < count; ++i) {
+        expected_shorts[i] = buffer.read<uint16_t>(true);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        expected_ints[i] = buffer.read<uint32_t>(true);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        expected_longs[i] = buffer.read<uint64_t>(true);
+    }
+
+    buffer.readPosition(0);
+
+    std::vector<uint16_t> result_shorts(count);
+    std::vector<uint32_t> result_ints(count);
+    std::vector<uint64_t> result_longs(count);
+    buffer.readArray(&result_shorts[0], count, true);
+    buffer.readArray(&result_ints[0], count, true);
+    buffer.readArray(&result_longs[0], count, true);
+
+    EXPECT_EQ(expected_shorts, result_shorts);
+    EXPECT_EQ(expected_ints, result_ints);
+    EXPECT_EQ(expected_longs, result_longs);
+}
+
+TEST(ByteBufferTests, SwapKernelsMatchPortableSwap)
+{
+    typedef void (*SwapKernel)(unsigned char*, size_t, size_t);
+
+    std::vector<SwapKernel> kernels;
+    kernels.push_back(anh::swapEndianArrayPortable);
+    if (anh::swapEndianArraySsse3Supported()) {
+        kernels.push_back(anh::swapEndianArraySsse3);
+    }
+    if (anh::swapEndianArrayAvx2Supported()) {
+        kernels.push_back(anh::swapEndianArrayAvx2);
+    }
+
+    // Start one byte in so the vector loads are unaligned.
+    std::vector<unsigned char> source(1 + 70 * 8);
+    for (size_t i = 0; i < source.size(); ++i) {
+        source[i] = static_cast<unsigned char>(i * 31 + 7);
+    }
+
+    const size_t element_sizes[] = {2, 4, 8};
+
+    for (size_t element_size : element_sizes) {
+        for (size_t count = 0; count <= 70; ++count) {
+            std::vector<unsigned char> expected(source);
+            for (size_t i = 0; i < count; ++i) {
+                unsigned char* element = &expected[1 + i * element_size];
+                std::reverse(element, element + element_size);
+            }
+
+            for (size_t k = 0; k < kernels.size(); ++k) {
+                std::vector<unsigned char> result(source);
+                kernels[k](&result[1], element_size, count);
+
+                EXPECT_EQ(expected, result)
+                    << "kernel " << k << ", element size " << element_size << ", count " << count;
+            }
+        }
+    }
+}
+
+TEST(ByteBufferTests, CanReadStringViewWithoutCopying)
+{
+    ByteBuffer buffer;
+    buffer.write<std::string>(std::string("player_name"));
+    buffer.write<int>(7);
+
+    anh::StringView view = buffer.readStringView();
+
+    EXPECT_EQ(std::string("player_name"), view.str());
+    EXPECT_EQ(reinterpret_cast<const char*>(buffer.data()) + sizeof(uint16_t), view.data());
+    EXPECT_EQ(7, buffer.read<int>());
+}
+
+TEST(ByteBufferTests, ReadingStringReusesExistingStorage)
+{
+    ByteBuffer buffer;
+    buffer.write<std::string>(std::string("first"));
+    buffer.write<std::string>(std::string("second"));
+
+    std::string data;
+    data.reserve(64);
+    const char* storage = data.data();
+
+    buffer.readString(data);
+    EXPECT_EQ("first", data);
+
+    buffer.readString(data);
+    EXPECT_EQ("second", data);
+    EXPECT_EQ(storage, data.data());
+}
+
+TEST(ByteBufferTests, ReadingStringPastBufferEndThrowsException)
+{
+    ByteBuffer buffer;
+    buffer.write<uint16_t>(10);
+    buffer.write<char>('a');
+
+    EXPECT_THROW(buffer.readStringView(), std::out_of_range);
+}
+
+TEST(ByteBufferTests, CanReadLongUnicodeStringWrittenToTheBuffer)
+{
+    ByteBuffer buffer;
+
+    // Use a length that is not a multiple of the vector width and characters
+    // outside of ascii to cover the full 16 bits of each unit.
+    std::wstring test_string;
+    for (int i = 0; i < 37; ++i) {
+        test_string += static_cast<wchar_t>(0x20 + i * 1733);
+    }
+
+    buffer.write<std::wstring>(test_string);
+    EXPECT_EQ(sizeof(uint32_t) + (37 * 2), buffer.size());
+
+    std::wstring result;
+    buffer.readString(result);
+    EXPECT_TRUE(test_string == result);
+}
+
+TEST(ByteBufferTests, ReadingUnicodeStringCanSwapEndian)
+{
+    ByteBuffer buffer;
+    std::wstring test_string(L"big endian chat text");
+
+    buffer.write<uint32_t>(anh::byteSwap<uint32_t>(static_cast<uint32_t>(test_string.length())));
+    for (size_t i = 0; i < test_string.length(); ++i) {
+        buffer.write<uint16_t>(anh::byteSwap<uint16_t>(static_cast<uint16_t>(test_string[i])));
+    }
+
+    EXPECT_STREQ(test_string.c_str(), buffer.read<std::wstring>(true).c_str());
+}
+
+TEST(ByteBufferTests, CursorReadsRequiredRegion)
+{
+    ByteBuffer buffer;
+    buffer.write<uint64_t>(0xDEADBEEF);
+    buffer.write<float>(1.5f);
+    buffer.write<uint16_t>(42);
+
+    {
+        anh::ReadCursor cursor(buffer);
+        cursor.require(sizeof(uint64_t) + sizeof(float));
+
+        EXPECT_EQ(uint64_t(0xDEADBEEF), cursor.get<uint64_t>());
+        EXPECT_EQ(1.5f, cursor.get<float>());
+        EXPECT_EQ(uint32_t(0), cursor.remaining());
+    }
+
+    // The cursor hands its position back to the buffer.
+    EXPECT_EQ(sizeof(uint64_t) + sizeof(float), buffer.readPosition());
+    EXPECT_EQ(42, buffer.read<uint16_t>());
+}
+
+TEST(ByteBufferTests, CursorRequiringPastBufferEndThrowsException)
+{
+    ByteBuffer buffer;
+    buffer.write<int>(1);
+    buffer.write<int>(2);
+    buffer.read<int>();
+
+    anh::ReadCursor cursor(buffer);
+    EXPECT_THROW(cursor.require(8), std::out_of_range);
+    EXPECT_NO_THROW(cursor.require(4));
+}
+
+TEST(ByteBufferTests, CursorCanReadBigEndianValues)
+{
+    ByteBuffer buffer;
+    anh::BigEndianWriter(buffer).write<uint32_t>(0x01020304).write<double>(0.5);
+
+    anh::BigEndianReadCursor cursor(buffer);
+    cursor.require(12);
+
+    EXPECT_EQ(uint32_t(0x01020304), cursor.get<uint32_t>());
+    EXPECT_EQ(0.5, cursor.get<double>());
+}
+
+TEST(ByteBufferTests, CursorReadingOutsideRegionAssertsInDebug)
+{
+    ByteBuffer buffer;
+    buffer.write<int>(1);
+    buffer.write<int>(2);
+
+    anh::ReadCursor cursor(buffer);
+    cursor.require(sizeof(int));
+    cursor.get<int>();
+
+    EXPECT_DEBUG_DEATH(cursor.get<int>(), "required region");
+}
+
 }  // namespace
@@ -0,0 +1,153 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#ifndef ANH_BYTE_ORDER_H_
+#define ANH_BYTE_ORDER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#ifdef _MSC_VER
+#include <stdlib.h>
+#endif
+
+// Windows only runs on little endian targets, everywhere else ask the compiler.
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define ANH_BIG_ENDIAN_HOST 1
+#endif
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+/// Maps a value size onto the type used to swap it and the function that
+/// does the swap. Sizes without an intrinsic, such as a 16 byte long double,
+/// reverse a plain copy of the bytes.
+template<size_t Size> struct ByteSwapTraits {
+    struct type {
+        unsigned char bytes[Size];
+    };
+
+    static type swap(type value) {
+        std::reverse(value.bytes, value.bytes + Size);
+        return value;
+    }
+};
+
+template<> struct ByteSwapTraits<1> {
+    typedef uint8_t type;
+    static type swap(type value) { return value; }
+};
+
+template<> struct ByteSwapTraits<2> {
+    typedef uint16_t type;
+    static type swap(type value) {
+#if defined(__GNUC__)
+        return __builtin_bswap16(value);
+#elif defined(_MSC_VER)
+        return _byteswap_ushort(value);
+#else
+        return static_cast<type>((value >> 8) | (value << 8));
+#endif
+    }
+};
+
+template<> struct ByteSwapTraits<4> {
+    typedef uint32_t type;
+    static type swap(type value) {
+#if defined(__GNUC__)
+        return __builtin_bswap32(value);
+#elif defined(_MSC_VER)
+        return _byteswap_ulong(value);
+#else
+        return (value >> 24) | ((value & 0x00FF0000) >> 8) |
+            ((value & 0x0000FF00) << 8) | (value << 24);
+#endif
+    }
+};
+
+template<> struct ByteSwapTraits<8> {
+    typedef uint64_t type;
+    static type swap(type value) {
+#if defined(__GNUC__)
+        return __builtin_bswap64(value);
+#elif defined(_MSC_VER)
+        return _byteswap_uint64(value);
+#else
+        return (static_cast<type>(ByteSwapTraits<4>::swap(static_cast<uint32_t>(value))) << 32) |
+            ByteSwapTraits<4>::swap(static_cast<uint32_t>(value >> 32));
+#endif
+    }
+};
+
+/*! \brief Reverses the byte order of a value.
+ *
+ * Arithmetic and enum types are swapped through an unsigned integer of the
+ * same size, so floats and doubles are handled as well as integers. Any other
+ * type has no defined byte order and fails to compile.
+ *
+ * swapBytes works on the stored representation instead. A swapped long
+ * double is not a valid value and may be altered when copied as one, so
+ * buffers swap the bytes before they become a T.
+ */
+template<typename T>
+struct ByteSwapper {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+        "Only arithmetic and enum types have a byte order");
+
+    static T swap(T value) {
+        swapBytes(reinterpret_cast<unsigned char*>(&value));
+        return value;
+    }
+
+    static void swapBytes(unsigned char* bytes) {
+        typedef ByteSwapTraits<sizeof(T)> Traits;
+
+        typename Traits::type bits;
+        std::memcpy(&bits, bytes, sizeof(T));
+        bits = Traits::swap(bits);
+        std::memcpy(bytes, &bits, sizeof(T));
+    }
+};
+
+/**
+ * Reverses the byte order of an arithmetic or enum value.
+ *
+ * \param value The value to swap.
+ * \returns The value with its bytes in reverse order.
+ */
+template<typename T>
+inline T byteSwap(T value) {
+    return ByteSwapper<T>::swap(value);
+}
+
+/// Byte order policy that leaves values in the host's order.
+struct NativeByteOrder {
+    static const bool is_swapped = false;
+
+    template<typename T> static T convert(T value) { return value; }
+    template<typename T> static void convertBytes(unsigned char*) {}
+};
+
+/// Byte order policy that reverses the host's order.
+struct SwappedByteOrder {
+    static const bool is_swapped = true;
+
+    template<typename T> static T convert(T value) { return byteSwap(value); }
+    template<typename T> static void convertBytes(unsigned char* bytes) { ByteSwapper<T>::swapBytes(bytes); }
+};
+
+#ifdef ANH_BIG_ENDIAN_HOST
+typedef SwappedByteOrder LittleEndianByteOrder;
+typedef NativeByteOrder BigEndianByteOrder;
+#else
+typedef NativeByteOrder LittleEndianByteOrder;
+typedef SwappedByteOrder BigEndianByteOrder;
+#endif
+
+}  // namespace anh
+
+#endif  // ANH_BYTE_ORDER_H_
@@ -0,0 +1,157 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/byte_order.h"
+
+#include <gtest/gtest.h>
+
+#include "anh/byte_buffer.h"
+
+using anh::BigEndianReader;
+using anh::BigEndianWriter;
+using anh::ByteBuffer;
+using anh::LittleEndianReader;
+using anh::LittleEndianWriter;
+
+// Wrapping tests in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+enum TestOpcode {
+    TEST_OPCODE = 0x01020304
+};
+
+TEST(ByteOrderTests, CanSwapIntegers)
+{
+    EXPECT_EQ(uint16_t(0x0201), anh::byteSwap<uint16_t>(0x0102));
+    EXPECT_EQ(uint32_t(0x04030201), anh::byteSwap<uint32_t>(0x01020304));
+    EXPECT_EQ(uint64_t(0x0807060504030201ULL), anh::byteSwap<uint64_t>(0x0102030405060708ULL));
+    EXPECT_EQ(int16_t(-2), anh::byteSwap<int16_t>(int16_t(0xFEFF)));
+    EXPECT_EQ(uint8_t(0x12), anh::byteSwap<uint8_t>(0x12));
+}
+
+TEST(ByteOrderTests, CanSwapFloatingPointValues)
+{
+    float f = 3.14159f;
+    double d = -2.718281828;
+
+    EXPECT_NE(f, anh::byteSwap(f));
+    EXPECT_EQ(f, anh::byteSwap(anh::byteSwap(f)));
+    EXPECT_EQ(d, anh::byteSwap(anh::byteSwap(d)));
+}
+
+TEST(ByteOrderTests, CanSwapBytesWithoutAnIntrinsic)
+{
+    unsigned char bytes[16];
+    for (unsigned char i = 0; i < 16; ++i) {
+        bytes[i] = i;
+    }
+
+    anh::ByteSwapper<long double>::swapBytes(bytes);
+
+    for (size_t i = 0; i < sizeof(long double); ++i) {
+        EXPECT_EQ(sizeof(long double) - 1 - i, bytes[i]);
+    }
+}
+
+TEST(ByteOrderTests, CanRoundTripLongDoubles)
+{
+    ByteBuffer buffer;
+    buffer.write<long double>(3.25L);
+    BigEndianWriter(buffer).write<long double>(-0.125L);
+
+    EXPECT_EQ(3.25L, buffer.read<long double>());
+    EXPECT_EQ(-0.125L, BigEndianReader(buffer).peek<long double>());
+    EXPECT_EQ(-0.125L, buffer.read<long double>(true));
+
+    buffer.readPosition(sizeof(long double));
+    anh::BigEndianReadCursor cursor(buffer);
+    cursor.require(sizeof(long double));
+    EXPECT_EQ(-0.125L, cursor.get<long double>());
+}
+
+TEST(ByteOrderTests, CanSwapEnums)
+{
+    EXPECT_EQ(0x04030201, static_cast<int>(anh::byteSwap(TEST_OPCODE)));
+}
+
+TEST(ByteOrderTests, BigEndianWriterStoresMostSignificantByteFirst)
+{
+    ByteBuffer buffer;
+    BigEndianWriter writer(buffer);
+    writer.write<uint32_t>(0x01020304).write<uint16_t>(0x0506);
+
+    EXPECT_EQ(uint32_t(6), buffer.size());
+    for (uint8_t i = 0; i < 6; ++i) {
+        EXPECT_EQ(i + 1, buffer.read<uint8_t>());
+    }
+}
+
+TEST(ByteOrderTests, LittleEndianWriterStoresLeastSignificantByteFirst)
+{
+    ByteBuffer buffer;
+    LittleEndianWriter writer(buffer);
+    writer.write<uint32_t>(0x04030201);
+
+    for (uint8_t i = 0; i < 4; ++i) {
+        EXPECT_EQ(i + 1, buffer.read<uint8_t>());
+    }
+}
+
+TEST(ByteOrderTests, ReaderRoundTripsEveryArithmeticType)
+{
+    ByteBuffer buffer;
+    BigEndianWriter writer(buffer);
+    writer.write<int8_t>(-3)
+        .write<uint16_t>(0xBEEF)
+        .write<int32_t>(-123456)
+        .write<uint64_t>(0x0123456789ABCDEFULL)
+        .write<float>(1.5f)
+        .write<double>(-0.25)
+        .write<TestOpcode>(TEST_OPCODE);
+
+    BigEndianReader reader(buffer);
+    EXPECT_EQ(-3, reader.read<int8_t>());
+    EXPECT_EQ(0xBEEF, reader.read<uint16_t>());
+    EXPECT_EQ(-123456, reader.read<int32_t>());
+    EXPECT_EQ(0x0123456789ABCDEFULL, reader.read<uint64_t>());
+    EXPECT_EQ(1.5f, reader.read<float>());
+    EXPECT_EQ(-0.25, reader.read<double>());
+    EXPECT_EQ(TEST_OPCODE, reader.read<TestOpcode>());
+}
+
+TEST(ByteOrderTests, ReaderMatchesRuntimeSwapFlag)
+{
+    ByteBuffer buffer;
+    buffer.write<uint32_t>(0x01020304);
+    buffer.write<float>(6.5f);
+
+    BigEndianReader big_endian(buffer);
+    LittleEndianReader little_endian(buffer);
+
+    EXPECT_EQ(buffer.peekAt<uint32_t>(0, true), big_endian.peekAt<uint32_t>(0));
+    EXPECT_EQ(buffer.peekAt<float>(4, true), big_endian.peekAt<float>(4));
+    EXPECT_EQ(6.5f, little_endian.peekAt<float>(4));
+    EXPECT_EQ(uint32_t(0x01020304), little_endian.peek<uint32_t>());
+}
+
+TEST(ByteOrderTests, WriterPrefixesStringsWithSwappedLength)
+{
+    ByteBuffer buffer;
+    BigEndianWriter(buffer).write<std::string>(std::string("zone")).write<std::wstring>(std::wstring(L"hi"));
+
+    ASSERT_EQ(size_t(2 + 4 + 4 + 2 * 2), buffer.size());
+    EXPECT_EQ(0x00, buffer.data()[0]);
+    EXPECT_EQ(0x04, buffer.data()[1]);
+    EXPECT_EQ('z', buffer.data()[2]);
+    EXPECT_EQ(0x02, buffer.data()[9]);
+    EXPECT_EQ(0x00, buffer.data()[10]);
+    EXPECT_EQ('h', buffer.data()[11]);
+
+    BigEndianReader reader(buffer);
+    EXPECT_EQ(std::string("zone"), reader.read<std::string>());
+    EXPECT_TRUE(std::wstring(L"hi") == reader.read<std::wstring>());
+    EXPECT_EQ(buffer.size(), buffer.readPosition());
+}
+
+}  // namespace
@@ -0,0 +1,87 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/crc_frame.h"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+CrcFrameWriter::CrcFrameWriter(ByteBuffer& buffer)
+    : buffer_(buffer)
+    , header_position_(buffer.writePosition())
+    , payload_end_(header_position_ + kFrameHeaderSize)
+    , crc_(kCrcSeed) {
+    // Placeholder for the length, filled in by seal.
+    buffer_.write<uint32_t>(0);
+}
+
+CrcFrameWriter& CrcFrameWriter::write(const unsigned char* data, size_t size) {
+    buffer_.write(data, size);
+    update(buffer_.writePosition());
+    return *this;
+}
+
+uint32_t CrcFrameWriter::seal() {
+    size_t length = payload_size() + kCrcTrailerSize;
+    if (length > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("Frame too large to encode");
+    }
+
+    uint32_t crc = ~crc_;
+
+    LittleEndianWriter writer(buffer_);
+    writer.writeAt<uint32_t>(header_position_, static_cast<uint32_t>(length));
+    writer.write<uint32_t>(crc);
+
+    return crc;
+}
+
+size_t CrcFrameWriter::payload_size() const {
+    return payload_end_ - header_position_ - kFrameHeaderSize;
+}
+
+void CrcFrameWriter::update(size_t payload_end) {
+    crc_ = memcrcUpdate(crc_, buffer_.data() + payload_end_, payload_end - payload_end_);
+    payload_end_ = payload_end;
+}
+
+FrameView stripCrcTrailer(const FrameView& frame) {
+    if (frame.length() < kCrcTrailerSize) {
+        throw std::runtime_error("Frame too short for a CRC trailer");
+    }
+
+    size_t payload_size = frame.length() - kCrcTrailerSize;
+
+    uint32_t expected;
+    std::memcpy(&expected, frame.data() + payload_size, sizeof(expected));
+    expected = LittleEndianByteOrder::convert(expected);
+
+    if (~memcrcUpdate(kCrcSeed, frame.data(), payload_size) != expected) {
+        throw std::runtime_error("CRC mismatch");
+    }
+
+    return FrameView(frame.data(), payload_size);
+}
+
+FrameView readCrcFrame(ByteBuffer& in) {
+    size_t frame_position = in.readPosition();
+    uint32_t length = LittleEndianReader(in).peek<uint32_t>();
+
+    size_t body_position = frame_position + kFrameHeaderSize;
+    if (in.size() - body_position < length) {
+        throw std::out_of_range("Read past end of buffer");
+    }
+
+    FrameView payload = stripCrcTrailer(FrameView(in.data() + body_position, length));
+    in.readPosition(body_position + length);
+
+    return payload;
+}
+
+}  // namespace anh
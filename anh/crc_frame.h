@@ -0,0 +1,100 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#ifndef ANH_CRC_FRAME_H_
+#define ANH_CRC_FRAME_H_
+
+#include <cstdint>
+
+#include "anh/byte_buffer.h"
+#include "anh/frame_decoder.h"
+#include "anh/memcrc.h"
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+/// Size of the little endian memcrc of the payload that ends every CRC frame.
+const size_t kCrcTrailerSize = sizeof(uint32_t);
+
+/*! \brief Writes a length prefixed frame whose payload is protected by a
+ * memcrc trailer.
+ *
+ * The checksum is updated as each value is written, while the bytes are still
+ * in cache, so sealing the frame never reads the payload a second time. The
+ * length is backpatched into the header in place.
+ *
+ * The length covers the payload and the trailer, so CRC frames can also be
+ * pulled out of a stream with FrameDecoder and checked with stripCrcTrailer.
+ *
+ * \code
+ * anh::CrcFrameWriter frame(buffer);
+ * frame.write<uint32_t>(opcode).write<std::string>(zone_name);
+ * frame.seal();
+ * \endcode
+ */
+class CrcFrameWriter {
+public:
+    /**
+     * Starts a frame at the write position of a buffer.
+     *
+     * \param buffer The buffer to write the frame to.
+     */
+    explicit CrcFrameWriter(ByteBuffer& buffer);
+
+    /// Writes a value with ByteBuffer::write<T> and adds its bytes to the checksum.
+    template<typename T> CrcFrameWriter& write(const T& data);
+
+    CrcFrameWriter& write(const unsigned char* data, size_t size);
+
+    /**
+     * Fills in the length and appends the checksum trailer. Nothing may be
+     * written to the frame afterwards.
+     *
+     * \returns The checksum of the payload.
+     */
+    uint32_t seal();
+
+    /// \returns The number of payload bytes written so far.
+    size_t payload_size() const;
+
+private:
+    void update(size_t payload_end);
+
+    ByteBuffer& buffer_;
+    size_t header_position_;
+    size_t payload_end_;
+    uint32_t crc_;
+};
+
+/**
+ * Verifies the trailer of a frame produced by CrcFrameWriter.
+ *
+ * \param frame The frame contents after the length prefix, payload and trailer.
+ * \returns A view of the payload.
+ * \throws std::runtime_error If the frame is too short or the checksum does not match.
+ */
+FrameView stripCrcTrailer(const FrameView& frame);
+
+/**
+ * Reads one frame produced by CrcFrameWriter from the read position of a
+ * buffer and verifies its checksum.
+ *
+ * \param in The buffer to read from, its read position is moved past the frame.
+ * \returns A view of the payload, valid until the buffer is next modified.
+ * \throws std::out_of_range If the frame runs past the end of the buffer.
+ * \throws std::runtime_error If the checksum does not match.
+ */
+FrameView readCrcFrame(ByteBuffer& in);
+
+template<typename T>
+CrcFrameWriter& CrcFrameWriter::write(const T& data) {
+    buffer_.write<T>(data);
+    update(buffer_.writePosition());
+    return *this;
+}
+
+}  // namespace anh
+
+#endif  // ANH_CRC_FRAME_H_
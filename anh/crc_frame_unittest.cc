@@ -0,0 +1,96 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/crc_frame.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+using anh::ByteBuffer;
+using anh::CrcFrameWriter;
+using anh::FrameView;
+
+// Wrapping tests in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+void writeSampleFrame(ByteBuffer& buffer, uint32_t opcode) {
+    CrcFrameWriter frame(buffer);
+    frame.write<uint32_t>(opcode)
+        .write<std::string>(std::string("zone_name"))
+        .write<uint64_t>(1234);
+    frame.seal();
+}
+
+TEST(CrcFrameTests, SealedFrameHasLengthPayloadAndChecksum)
+{
+    ByteBuffer buffer;
+    CrcFrameWriter frame(buffer);
+    frame.write<uint32_t>(7).write<uint16_t>(9);
+    EXPECT_EQ(6u, frame.payload_size());
+
+    uint32_t crc = frame.seal();
+
+    ASSERT_EQ(anh::kFrameHeaderSize + 6 + anh::kCrcTrailerSize, buffer.size());
+    EXPECT_EQ(uint32_t(6 + anh::kCrcTrailerSize), buffer.peekAt<uint32_t>(0));
+    EXPECT_EQ(anh::memcrc(reinterpret_cast<const char*>(buffer.data() + 4), 6), crc);
+    EXPECT_EQ(crc, buffer.peekAt<uint32_t>(10));
+}
+
+TEST(CrcFrameTests, CanReadSealedFrames)
+{
+    ByteBuffer buffer;
+    writeSampleFrame(buffer, 1);
+    writeSampleFrame(buffer, 2);
+
+    FrameView first = anh::readCrcFrame(buffer);
+    FrameView second = anh::readCrcFrame(buffer);
+    EXPECT_EQ(buffer.size(), buffer.readPosition());
+
+    ByteBuffer payload = first.copy();
+    EXPECT_EQ(uint32_t(1), payload.read<uint32_t>());
+    EXPECT_EQ(std::string("zone_name"), payload.read<std::string>());
+    EXPECT_EQ(uint64_t(1234), payload.read<uint64_t>());
+
+    EXPECT_EQ(first.length(), second.length());
+    EXPECT_EQ(uint32_t(2), second.copy().read<uint32_t>());
+}
+
+TEST(CrcFrameTests, CorruptPayloadThrowsException)
+{
+    ByteBuffer buffer;
+    writeSampleFrame(buffer, 1);
+
+    buffer.raw()[anh::kFrameHeaderSize + 5] ^= 0x01;
+
+    EXPECT_THROW(anh::readCrcFrame(buffer), std::runtime_error);
+    EXPECT_EQ(0u, buffer.readPosition());
+}
+
+TEST(CrcFrameTests, TruncatedFrameThrowsException)
+{
+    ByteBuffer buffer;
+    writeSampleFrame(buffer, 1);
+    buffer.raw().resize(buffer.size() - 1);
+
+    EXPECT_THROW(anh::readCrcFrame(buffer), std::out_of_range);
+}
+
+TEST(CrcFrameTests, FramesCanBeDecodedFromAStream)
+{
+    ByteBuffer stream;
+    writeSampleFrame(stream, 42);
+
+    anh::FrameDecoder decoder;
+    decoder.feed(stream.data(), stream.size());
+
+    FrameView frame;
+    ASSERT_TRUE(decoder.next(frame));
+
+    FrameView payload = anh::stripCrcTrailer(frame);
+    EXPECT_EQ(frame.length() - anh::kCrcTrailerSize, payload.length());
+    EXPECT_EQ(uint32_t(42), payload.copy().read<uint32_t>());
+}
+
+}  // namespace
@@ -0,0 +1,187 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/delta_codec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ANH_DELTA_CODEC_SSE2 1
+#endif
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+namespace {
+
+// Compares the blocks of two buffers, both holding at least
+// block_count * kDeltaBlockSize bytes.
+class BlockComparer {
+public:
+    BlockComparer(const unsigned char* baseline, const unsigned char* current, size_t block_count)
+        : baseline_(baseline)
+        , current_(current)
+        , block_count_(block_count) {}
+
+    /// \returns The first block at or after block that differs, or block_count.
+    size_t nextChanged(size_t block) const {
+#ifdef ANH_DELTA_CODEC_SSE2
+        // Unchanged state is the common case, so skip four blocks at a time
+        // while all 64 bytes match.
+        while (block + 4 <= block_count_ && !differs(block, 4)) {
+            block += 4;
+        }
+#endif
+
+        while (block < block_count_ && !differs(block, 1)) {
+            ++block;
+        }
+
+        return block;
+    }
+
+    /// \returns The first block at or after block that matches, or block_count.
+    size_t nextUnchanged(size_t block) const {
+        while (block < block_count_ && differs(block, 1)) {
+            ++block;
+        }
+
+        return block;
+    }
+
+private:
+    bool differs(size_t block, size_t count) const {
+        const unsigned char* baseline = baseline_ + block * kDeltaBlockSize;
+        const unsigned char* current = current_ + block * kDeltaBlockSize;
+
+#ifdef ANH_DELTA_CODEC_SSE2
+        __m128i equal = _mm_set1_epi8(-1);
+
+        for (size_t i = 0; i < count; ++i) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(baseline + i * kDeltaBlockSize));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current + i * kDeltaBlockSize));
+            equal = _mm_and_si128(equal, _mm_cmpeq_epi8(a, b));
+        }
+
+        return _mm_movemask_epi8(equal) != 0xFFFF;
+#else
+        return std::memcmp(baseline, current, count * kDeltaBlockSize) != 0;
+#endif
+    }
+
+    const unsigned char* baseline_;
+    const unsigned char* current_;
+    size_t block_count_;
+};
+
+// Writes an LEB128 varint, matching ByteBuffer::writeVarint.
+unsigned char* putVarint(unsigned char* out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = static_cast<unsigned char>(value | 0x80);
+        value >>= 7;
+    }
+
+    *out++ = static_cast<unsigned char>(value);
+    return out;
+}
+
+}  // namespace
+
+void encodeDelta(const ByteBuffer& baseline, const ByteBuffer& current, ByteBuffer& out) {
+    size_t size = current.size();
+    size_t block_count = (size + kDeltaBlockSize - 1) / kDeltaBlockSize;
+
+    // Only whole blocks inside both buffers are compared, anything past the
+    // end of either is sent as is.
+    size_t comparable = std::min(size, baseline.size()) / kDeltaBlockSize;
+    BlockComparer comparer(baseline.data(), current.data(), comparable);
+
+    // Every run starts with at least one block, so there are at most one
+    // more runs than blocks. Writing into space sized for the worst case
+    // avoids growing the buffer for each run.
+    size_t worst_case = ByteBuffer::varintSize(size) +
+        (block_count + 1) * 2 * ByteBuffer::varintSize(block_count) + size;
+
+    unsigned char* start = out.prepare(worst_case);
+    unsigned char* cursor = putVarint(start, size);
+
+    size_t block = 0;
+    while (block < block_count) {
+        size_t changed = (block < comparable) ? comparer.nextChanged(block) : block;
+        size_t unchanged = (changed < comparable) ? comparer.nextUnchanged(changed) : block_count;
+
+        // A changed run that reaches the end of the comparable blocks carries
+        // on through the rest of the buffer.
+        if (unchanged == comparable) {
+            unchanged = block_count;
+        }
+
+        cursor = putVarint(cursor, changed - block);
+        cursor = putVarint(cursor, unchanged - changed);
+
+        if (unchanged > changed) {
+            size_t offset = changed * kDeltaBlockSize;
+            size_t length = std::min(unchanged * kDeltaBlockSize, size) - offset;
+
+            std::memcpy(cursor, current.data() + offset, length);
+            cursor += length;
+        }
+
+        block = unchanged;
+    }
+
+    out.commit(cursor - start);
+}
+
+void applyDelta(const ByteBuffer& baseline, ByteBuffer& delta, ByteBuffer& out) {
+    uint64_t size = delta.readVarint<uint64_t>();
+    uint64_t block_count = (size + kDeltaBlockSize - 1) / kDeltaBlockSize;
+
+    // The delta can't describe more bytes than it and the baseline hold.
+    if (size > baseline.size() + (delta.size() - delta.readPosition())) {
+        throw std::runtime_error("Delta does not fit the baseline");
+    }
+
+    unsigned char* result = out.prepare(static_cast<size_t>(size));
+
+    uint64_t block = 0;
+    while (block < block_count) {
+        uint64_t unchanged = delta.readVarint<uint64_t>();
+        uint64_t changed = delta.readVarint<uint64_t>();
+
+        if (unchanged > block_count - block || changed > block_count - block - unchanged
+            || unchanged + changed == 0) {
+            throw std::runtime_error("Delta does not fit the baseline");
+        }
+
+        if (unchanged) {
+            size_t offset = static_cast<size_t>(block * kDeltaBlockSize);
+            size_t length = static_cast<size_t>(unchanged * kDeltaBlockSize);
+
+            if (offset + length > baseline.size() || offset + length > size) {
+                throw std::runtime_error("Delta does not fit the baseline");
+            }
+
+            std::memcpy(result + offset, baseline.data() + offset, length);
+            block += unchanged;
+        }
+
+        if (changed) {
+            size_t offset = static_cast<size_t>(block * kDeltaBlockSize);
+            size_t length = std::min(static_cast<size_t>((block + changed) * kDeltaBlockSize),
+                static_cast<size_t>(size)) - offset;
+
+            delta.readArray(result + offset, length);
+            block += changed;
+        }
+    }
+
+    out.commit(static_cast<size_t>(size));
+}
+
+}  // namespace anh
@@ -0,0 +1,48 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#ifndef ANH_DELTA_CODEC_H_
+#define ANH_DELTA_CODEC_H_
+
+#include <cstdint>
+
+#include "anh/byte_buffer.h"
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+/// Granularity of the delta codec, blocks are either copied from the
+/// baseline or sent in full.
+const size_t kDeltaBlockSize = 16;
+
+/**
+ * Encodes a buffer as the difference from a baseline both sides already hold,
+ * such as the last acknowledged state of the same subject.
+ *
+ * Both buffers are compared in 16 byte blocks. The delta holds the size of
+ * the current buffer followed by runs of unchanged and changed blocks, each
+ * as a varint count, with the bytes of the changed blocks after each run.
+ * Blocks past the end of the baseline always count as changed.
+ *
+ * \param baseline The buffer the receiver already has.
+ * \param current The buffer to encode.
+ * \param out The buffer the delta is written to.
+ */
+void encodeDelta(const ByteBuffer& baseline, const ByteBuffer& current, ByteBuffer& out);
+
+/**
+ * Rebuilds a buffer from its baseline and a delta written by encodeDelta.
+ *
+ * \param baseline The baseline the delta was encoded against.
+ * \param delta The buffer to read the delta from, starting at its read position.
+ * \param out The buffer the result is appended to.
+ * \throws std::out_of_range If the delta runs past the end of its buffer.
+ * \throws std::runtime_error If the delta does not fit the baseline.
+ */
+void applyDelta(const ByteBuffer& baseline, ByteBuffer& delta, ByteBuffer& out);
+
+}  // namespace anh
+
+#endif  // ANH_DELTA_CODEC_H_
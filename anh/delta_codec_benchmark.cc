@@ -0,0 +1,66 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/delta_codec.h"
+
+#include <benchmark/benchmark.h>
+
+using anh::ByteBuffer;
+
+// Wrapping benchmarks in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+const size_t kStateSize = 4096;
+
+// A state blob and a copy with the given number of scattered fields changed,
+// the way a tick's worth of updates touches a subject.
+void makeStates(size_t changes, ByteBuffer& baseline, ByteBuffer& current) {
+    for (size_t i = 0; i < kStateSize; ++i) {
+        baseline.write<uint8_t>(static_cast<uint8_t>(i * 31 + 7));
+    }
+
+    current = baseline;
+    for (size_t i = 0; i < changes; ++i) {
+        current.writeAt<uint32_t>((i * 977) % (kStateSize - 4), static_cast<uint32_t>(i + 1));
+    }
+}
+
+void BM_EncodeDelta(benchmark::State& state) {
+    ByteBuffer baseline, current;
+    makeStates(static_cast<size_t>(state.range(0)), baseline, current);
+
+    ByteBuffer delta;
+    for (auto _ : state) {
+        delta.clear();
+        anh::encodeDelta(baseline, current, delta);
+        benchmark::DoNotOptimize(delta.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * kStateSize);
+    state.counters["delta_bytes"] = static_cast<double>(delta.size());
+}
+BENCHMARK(BM_EncodeDelta)->Arg(0)->Arg(4)->Arg(32)->Arg(256);
+
+void BM_ApplyDelta(benchmark::State& state) {
+    ByteBuffer baseline, current;
+    makeStates(static_cast<size_t>(state.range(0)), baseline, current);
+
+    ByteBuffer delta;
+    anh::encodeDelta(baseline, current, delta);
+
+    ByteBuffer result;
+    result.reserve(kStateSize);
+
+    for (auto _ : state) {
+        delta.readPosition(0);
+        result.clear();
+        anh::applyDelta(baseline, delta, result);
+        benchmark::DoNotOptimize(result.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * kStateSize);
+}
+BENCHMARK(BM_ApplyDelta)->Arg(0)->Arg(4)->Arg(32)->Arg(256);
+
+}  // namespace
@@ -0,0 +1,116 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/delta_codec.h"
+
+#include <gtest/gtest.h>
+
+using anh::ByteBuffer;
+
+// Wrapping tests in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+ByteBuffer makeState(size_t size) {
+    ByteBuffer state;
+    for (size_t i = 0; i < size; ++i) {
+        state.write<uint8_t>(static_cast<uint8_t>(i * 31 + 7));
+    }
+
+    return state;
+}
+
+// Encodes current against baseline, applies the delta and checks the result.
+size_t roundTrip(const ByteBuffer& baseline, const ByteBuffer& current) {
+    ByteBuffer delta;
+    anh::encodeDelta(baseline, current, delta);
+
+    ByteBuffer result;
+    anh::applyDelta(baseline, delta, result);
+
+    EXPECT_EQ(delta.size(), delta.readPosition());
+    EXPECT_EQ(current.size(), result.size());
+    EXPECT_EQ(0, memcmp(current.data(), result.data(), current.size()));
+
+    return delta.size();
+}
+
+TEST(DeltaCodecTests, IdenticalBuffersEncodeToAFewBytes)
+{
+    ByteBuffer baseline = makeState(4096);
+
+    // The size, one unchanged run and an empty changed run.
+    EXPECT_EQ(anh::ByteBuffer::varintSize(4096) + 2 + 1, roundTrip(baseline, baseline));
+}
+
+TEST(DeltaCodecTests, OnlyChangedBlocksAreSent)
+{
+    ByteBuffer baseline = makeState(4096);
+    ByteBuffer current(baseline);
+
+    current.writeAt<uint32_t>(100, 0xDEADBEEF);
+    current.writeAt<uint8_t>(4000, 0);
+
+    size_t delta_size = roundTrip(baseline, current);
+
+    // Two 16 byte blocks changed (the write at 100 stays inside block 6).
+    EXPECT_LT(delta_size, 2 * anh::kDeltaBlockSize + 16);
+    EXPECT_GE(delta_size, 2 * anh::kDeltaBlockSize);
+}
+
+TEST(DeltaCodecTests, HandlesBuffersThatGrowAndShrink)
+{
+    ByteBuffer baseline = makeState(100);
+
+    ByteBuffer longer = makeState(257);
+    longer.writeAt<uint8_t>(20, 0xFF);
+    roundTrip(baseline, longer);
+
+    ByteBuffer shorter = makeState(37);
+    roundTrip(baseline, shorter);
+
+    ByteBuffer empty;
+    roundTrip(baseline, empty);
+    roundTrip(empty, shorter);
+}
+
+TEST(DeltaCodecTests, ChangesInEveryBlockRoundTrip)
+{
+    ByteBuffer baseline = makeState(1000);
+
+    for (size_t offset = 0; offset < 1000; offset += 7) {
+        ByteBuffer current(baseline);
+        current.writeAt<uint8_t>(offset, static_cast<uint8_t>(~baseline.data()[offset]));
+
+        roundTrip(baseline, current);
+    }
+}
+
+TEST(DeltaCodecTests, DeltaAgainstWrongBaselineThrowsException)
+{
+    ByteBuffer baseline = makeState(4096);
+    ByteBuffer current(baseline);
+    current.writeAt<uint32_t>(2000, 1);
+
+    ByteBuffer delta;
+    anh::encodeDelta(baseline, current, delta);
+
+    ByteBuffer short_baseline = makeState(64);
+    ByteBuffer result;
+    EXPECT_THROW(anh::applyDelta(short_baseline, delta, result), std::runtime_error);
+}
+
+TEST(DeltaCodecTests, TruncatedDeltaThrowsException)
+{
+    ByteBuffer baseline;
+    ByteBuffer current = makeState(64);
+
+    ByteBuffer delta;
+    anh::encodeDelta(baseline, current, delta);
+    delta.raw().resize(delta.size() - 1);
+
+    ByteBuffer result;
+    EXPECT_THROW(anh::applyDelta(baseline, delta, result), std::out_of_range);
+}
+
+}  // namespace
@@ -69,9 +69,19 @@ void BaseEvent::next(IEventPtr next) {
 }
 
 void BaseEvent::serialize(ByteBuffer& out) const {
-    out.write<uint32_t>(event_type().ident());
+    EventSizeTracker& tracker = size_tracker();
+    uint32_t ident = event_type().ident();
+
+    // Growing the buffer once up front replaces the regrowth that writing
+    // a large event field by field would otherwise cause.
+    out.prepare(tracker.predict(ident));
+    size_t size_before = out.size();
+
+    out.write<uint32_t>(ident);
 
     onSerialize(out);
+
+    tracker.record(ident, out.size() - size_before);
 }
 
 void BaseEvent::deserialize(ByteBuffer& in) {
@@ -94,6 +104,11 @@ void BaseEvent::consume(bool handled) const {
     }
 }
 
+EventSizeTracker& BaseEvent::size_tracker() {
+    static EventSizeTracker tracker;
+    return tracker;
+}
+
 SimpleEvent::SimpleEvent(EventType& event_type, uint64_t subject_id, uint64_t delay_ms)
     : BaseEvent(subject_id, delay_ms)
     , event_type_(event_type) {}
@@ -9,6 +9,7 @@
 #include <memory>
 
 #include "anh/byte_buffer.h"
+#include "anh/event_size_tracker.h"
 #include "anh/hash_string.h"
 
 /// The anh namespace hosts a number of useful utility classes intended
@@ -105,11 +106,19 @@ public:
     IEventPtr next() const;
     void next(IEventPtr next);
 
+    /*! Serializes the event, first making room for as many bytes as events
+     * of its type have recently needed.
+     *
+     * \param out The ByteBuffer instance to stream the event data to.
+     */
     void serialize(ByteBuffer& out) const;
     void deserialize(ByteBuffer& in);
 
     void consume(bool handled) const;
 
+    /// \returns The tracker that learns the serialized size of each event type.
+    static EventSizeTracker& size_tracker();
+
 protected:
     virtual bool onConsume(bool handled) const = 0;
     virtual void onSerialize(ByteBuffer& out) const = 0;
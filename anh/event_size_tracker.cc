@@ -0,0 +1,138 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/event_size_tracker.h"
+
+#include <algorithm>
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+namespace {
+
+// An empty slot holds ident 0, so events whose type hashes to 0 are not
+// tracked.
+const uint32_t kEmptyIdent = 0;
+
+// Every smaller size moves the prediction 1/32 of the way down, so it takes
+// a long run of small events before a large one has to regrow again.
+const unsigned kDecayShift = 5;
+
+size_t homeSlot(uint32_t ident) {
+    // The idents are already crc values, Fibonacci hashing spreads the high
+    // bits over the table.
+    return static_cast<size_t>((ident * 2654435769u) >> 22) & (EventSizeTracker::CAPACITY - 1);
+}
+
+uint32_t clampSize(size_t size) {
+    return static_cast<uint32_t>(std::min<size_t>(size, 0xFFFFFFFF));
+}
+
+}  // namespace
+
+EventSizeTracker::EventSizeTracker()
+    : tracked_types_(0) {
+    for (size_t i = 0; i < CAPACITY; ++i) {
+        slots_[i].ident.store(kEmptyIdent, std::memory_order_relaxed);
+        slots_[i].predicted.store(0, std::memory_order_relaxed);
+        slots_[i].largest.store(0, std::memory_order_relaxed);
+        slots_[i].samples.store(0, std::memory_order_relaxed);
+    }
+}
+
+void EventSizeTracker::record(uint32_t ident, size_t size) {
+    Slot* slot = findOrInsert(ident);
+    if (!slot) {
+        return;
+    }
+
+    uint32_t value = clampSize(size);
+
+    slot->samples.fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t largest = slot->largest.load(std::memory_order_relaxed);
+    while (value > largest && !slot->largest.compare_exchange_weak(largest, value, std::memory_order_relaxed)) {}
+
+    // Concurrent updates may overwrite each other, which only costs a little
+    // accuracy in the prediction.
+    uint32_t predicted = slot->predicted.load(std::memory_order_relaxed);
+    if (value >= predicted) {
+        slot->predicted.store(value, std::memory_order_relaxed);
+    } else {
+        slot->predicted.store(predicted - ((predicted - value) >> kDecayShift), std::memory_order_relaxed);
+    }
+}
+
+size_t EventSizeTracker::predict(uint32_t ident) const {
+    const Slot* slot = find(ident);
+    return slot ? slot->predicted.load(std::memory_order_relaxed) : 0;
+}
+
+EventSizeStats EventSizeTracker::stats(uint32_t ident) const {
+    EventSizeStats stats = { 0, 0, 0 };
+
+    if (const Slot* slot = find(ident)) {
+        stats.samples = slot->samples.load(std::memory_order_relaxed);
+        stats.predicted = slot->predicted.load(std::memory_order_relaxed);
+        stats.largest = slot->largest.load(std::memory_order_relaxed);
+    }
+
+    return stats;
+}
+
+size_t EventSizeTracker::tracked_types() const {
+    return tracked_types_.load(std::memory_order_relaxed);
+}
+
+const EventSizeTracker::Slot* EventSizeTracker::find(uint32_t ident) const {
+    if (ident == kEmptyIdent) {
+        return nullptr;
+    }
+
+    size_t index = homeSlot(ident);
+    for (size_t probe = 0; probe < CAPACITY; ++probe) {
+        uint32_t current = slots_[index].ident.load(std::memory_order_acquire);
+
+        if (current == ident) {
+            return &slots_[index];
+        }
+
+        if (current == kEmptyIdent) {
+            return nullptr;
+        }
+
+        index = (index + 1) & (CAPACITY - 1);
+    }
+
+    return nullptr;
+}
+
+EventSizeTracker::Slot* EventSizeTracker::findOrInsert(uint32_t ident) {
+    if (ident == kEmptyIdent) {
+        return nullptr;
+    }
+
+    size_t index = homeSlot(ident);
+    for (size_t probe = 0; probe < CAPACITY; ++probe) {
+        uint32_t current = slots_[index].ident.load(std::memory_order_acquire);
+
+        if (current == kEmptyIdent &&
+            slots_[index].ident.compare_exchange_strong(current, ident, std::memory_order_acq_rel)) {
+            tracked_types_.fetch_add(1, std::memory_order_relaxed);
+            return &slots_[index];
+        }
+
+        // Either the slot was already taken or another thread just claimed it.
+        if (current == ident) {
+            return &slots_[index];
+        }
+
+        index = (index + 1) & (CAPACITY - 1);
+    }
+
+    return nullptr;
+}
+
+}  // namespace anh
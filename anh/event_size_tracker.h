@@ -0,0 +1,86 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#ifndef ANH_EVENT_SIZE_TRACKER_H_
+#define ANH_EVENT_SIZE_TRACKER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+/*! \brief What an EventSizeTracker has seen of one event type.
+ */
+struct EventSizeStats {
+    uint64_t samples;   ///< Number of serialized sizes recorded.
+    size_t predicted;   ///< The size the next serialization reserves.
+    size_t largest;     ///< The largest size recorded.
+};
+
+/*! \brief Learns how large each event type serializes to, so the output
+ * buffer can be grown once up front instead of several times while writing.
+ *
+ * The prediction for a type tracks a high percentile of its recent sizes: it
+ * jumps straight to any larger size and decays slowly towards smaller ones,
+ * so the occasional small event doesn't cause the next large one to regrow.
+ *
+ * Types are kept in a fixed table without locking, and recording and
+ * predicting never allocate. Types beyond the capacity of the table are not
+ * tracked and predict nothing.
+ *
+ * \see BaseEvent::size_tracker
+ */
+class EventSizeTracker {
+public:
+    /// The number of event types that can be tracked.
+    enum { CAPACITY = 1024 };
+
+    EventSizeTracker();
+
+    /**
+     * Records the serialized size of an event.
+     *
+     * \param ident The ident of the event's type.
+     * \param size The number of bytes the event serialized to.
+     */
+    void record(uint32_t ident, size_t size);
+
+    /**
+     * \param ident The ident of an event type.
+     * \returns The number of bytes to reserve before serializing an event of
+     *     the type, or 0 if it has not been seen.
+     */
+    size_t predict(uint32_t ident) const;
+
+    /// \returns A snapshot of what has been recorded for an event type.
+    EventSizeStats stats(uint32_t ident) const;
+
+    /// \returns The number of event types being tracked.
+    size_t tracked_types() const;
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> ident;
+        std::atomic<uint32_t> predicted;
+        std::atomic<uint32_t> largest;
+        std::atomic<uint64_t> samples;
+    };
+
+    /// Disable copying, the table is shared by every serializing thread.
+    EventSizeTracker(const EventSizeTracker&);
+    EventSizeTracker& operator=(const EventSizeTracker&);
+
+    const Slot* find(uint32_t ident) const;
+    Slot* findOrInsert(uint32_t ident);
+
+    Slot slots_[CAPACITY];
+    std::atomic<size_t> tracked_types_;
+};
+
+}  // namespace anh
+
+#endif  // ANH_EVENT_SIZE_TRACKER_H_
@@ -0,0 +1,102 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/event_size_tracker.h"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+
+using anh::EventSizeStats;
+using anh::EventSizeTracker;
+
+// Wrapping tests in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+const uint32_t kIdent = 0xC3CEA198;
+
+TEST(EventSizeTrackerTests, UnknownTypePredictsNothing)
+{
+    EventSizeTracker tracker;
+
+    EXPECT_EQ(0u, tracker.predict(kIdent));
+    EXPECT_EQ(0u, tracker.stats(kIdent).samples);
+    EXPECT_EQ(0u, tracker.tracked_types());
+}
+
+TEST(EventSizeTrackerTests, RepeatedSizeIsPredictedExactly)
+{
+    EventSizeTracker tracker;
+
+    for (int i = 0; i < 10; ++i) {
+        tracker.record(kIdent, 300);
+    }
+
+    EventSizeStats stats = tracker.stats(kIdent);
+    EXPECT_EQ(10u, stats.samples);
+    EXPECT_EQ(300u, stats.predicted);
+    EXPECT_EQ(300u, stats.largest);
+    EXPECT_EQ(300u, tracker.predict(kIdent));
+}
+
+TEST(EventSizeTrackerTests, LargerSizeRaisesPredictionImmediately)
+{
+    EventSizeTracker tracker;
+
+    tracker.record(kIdent, 100);
+    tracker.record(kIdent, 500);
+
+    EXPECT_EQ(500u, tracker.predict(kIdent));
+}
+
+TEST(EventSizeTrackerTests, SmallerSizesDecaySlowly)
+{
+    EventSizeTracker tracker;
+
+    tracker.record(kIdent, 1000);
+    tracker.record(kIdent, 100);
+
+    // A single small event barely moves the prediction...
+    size_t predicted = tracker.predict(kIdent);
+    EXPECT_LT(predicted, 1000u);
+    EXPECT_GT(predicted, 900u);
+
+    // ...but a long run of them brings it down.
+    for (int i = 0; i < 200; ++i) {
+        tracker.record(kIdent, 100);
+    }
+
+    EXPECT_LT(tracker.predict(kIdent), 200u);
+    EXPECT_GE(tracker.predict(kIdent), 100u);
+    EXPECT_EQ(1000u, tracker.stats(kIdent).largest);
+}
+
+TEST(EventSizeTrackerTests, TypesAreTrackedSeparately)
+{
+    EventSizeTracker tracker;
+
+    tracker.record(1, 10);
+    tracker.record(2, 20);
+    tracker.record(1, 10);
+
+    EXPECT_EQ(2u, tracker.tracked_types());
+    EXPECT_EQ(10u, tracker.predict(1));
+    EXPECT_EQ(20u, tracker.predict(2));
+    EXPECT_EQ(2u, tracker.stats(1).samples);
+}
+
+TEST(EventSizeTrackerTests, FullTableStopsTrackingNewTypes)
+{
+    std::unique_ptr<EventSizeTracker> tracker(new EventSizeTracker);
+
+    for (uint32_t ident = 1; ident <= EventSizeTracker::CAPACITY + 10; ++ident) {
+        tracker->record(ident, ident);
+    }
+
+    EXPECT_EQ(size_t(EventSizeTracker::CAPACITY), tracker->tracked_types());
+    EXPECT_EQ(1u, tracker->predict(1));
+    EXPECT_EQ(0u, tracker->predict(EventSizeTracker::CAPACITY + 10));
+}
+
+}  // namespace
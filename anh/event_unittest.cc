@@ -4,6 +4,10 @@
 
 #include "anh/event.h"
 
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
 #include <gtest/gtest.h>
 
 using anh::BaseEvent;
@@ -13,6 +17,30 @@ using anh::EventCallback;
 using anh::EventType;
 using anh::EventPriority;
 using anh::EventSubject;
+using anh::SimpleEvent;
+
+namespace {
+
+// Counts every allocation made through the global operator new so tests can
+// check that a code path does not touch the heap.
+std::atomic<size_t> allocation_count(0);
+
+}  // namespace
+
+void* operator new(size_t size) {
+    ++allocation_count;
+
+    void* memory = std::malloc(size ? size : 1);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
 
 // Wrapping tests in an anonymous namespace prevents potential name conflicts.
 namespace {
@@ -56,6 +84,32 @@ private:
 };
     
 const EventType MockEvent::event_type_ = EventType("mock_event");
+
+// An event large enough that serializing it field by field regrows a buffer
+// several times.
+class LargeMockEvent : public BaseEvent {
+public:
+    enum { FIELD_COUNT = 64 };
+
+    const EventType& event_type() const { return event_type_; }
+
+private:
+    void onSerialize(ByteBuffer& out) const {
+        for (uint64_t i = 0; i < FIELD_COUNT; ++i) {
+            out.write<uint64_t>(i);
+        }
+    }
+
+    void onDeserialize(ByteBuffer& in) {}
+
+    bool onConsume(bool handled) const {
+        return true;
+    }
+
+    static const EventType event_type_;
+};
+
+const EventType LargeMockEvent::event_type_ = EventType("large_mock_event");
     
 /*! All events should have a type and a way of returning that type to a caller.
  */
@@ -200,4 +254,80 @@ TEST(EventTests, CanSerializeEventToBuffer) {
     EXPECT_EQ(27, buffer.read<int>());
 }
 
+TEST(EventTests, SerializingSimpleEventDoesNotAllocate) {
+    EventType event_type("simple_event");
+    SimpleEvent test_event(event_type, 42, 0);
+
+    size_t allocations_before = allocation_count;
+
+    ByteBuffer buffer;
+    test_event.serialize(buffer);
+
+    EXPECT_EQ(allocations_before, allocation_count);
+    EXPECT_EQ(event_type.ident(), buffer.read<uint32_t>());
+}
+
+TEST(EventTests, SerializingManySimpleEventsAllocatesOnlyWhenSpilling) {
+    EventType event_type("simple_event");
+    SimpleEvent test_event(event_type, 42, 0);
+
+    size_t events_inline = ByteBuffer::INLINE_CAPACITY / sizeof(uint32_t);
+    size_t allocations_before = allocation_count;
+
+    ByteBuffer buffer;
+    for (size_t i = 0; i < events_inline; ++i) {
+        test_event.serialize(buffer);
+    }
+
+    EXPECT_EQ(allocations_before, allocation_count);
+
+    // One more event no longer fits inline and moves the buffer to the heap.
+    test_event.serialize(buffer);
+    EXPECT_EQ(allocations_before + 1, allocation_count);
+}
+
+TEST(EventTests, RepeatedSerializationSettlesAtOneAllocation) {
+    LargeMockEvent test_event;
+
+    {
+        ByteBuffer buffer;
+        test_event.serialize(buffer);
+    }
+
+    size_t allocations_before = allocation_count;
+
+    ByteBuffer buffer;
+    test_event.serialize(buffer);
+
+    EXPECT_EQ(allocations_before + 1, allocation_count);
+    EXPECT_EQ(sizeof(uint32_t) + LargeMockEvent::FIELD_COUNT * sizeof(uint64_t), buffer.size());
+}
+
+TEST(EventTests, SerializingIntoReservedBufferDoesNotAllocate) {
+    LargeMockEvent test_event;
+
+    ByteBuffer buffer;
+    test_event.serialize(buffer);
+    buffer.clear();
+
+    size_t allocations_before = allocation_count;
+
+    test_event.serialize(buffer);
+
+    EXPECT_EQ(allocations_before, allocation_count);
+}
+
+TEST(EventTests, SerializedSizesAreTracked) {
+    LargeMockEvent test_event;
+    size_t size = sizeof(uint32_t) + LargeMockEvent::FIELD_COUNT * sizeof(uint64_t);
+
+    ByteBuffer buffer;
+    test_event.serialize(buffer);
+
+    anh::EventSizeStats stats = BaseEvent::size_tracker().stats(test_event.event_type().ident());
+    EXPECT_LE(1u, stats.samples);
+    EXPECT_EQ(size, stats.predicted);
+    EXPECT_EQ(size, stats.largest);
+}
+
 }  // namespace
@@ -0,0 +1,212 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#ifndef ANH_FIELD_LIST_H_
+#define ANH_FIELD_LIST_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "anh/byte_buffer.h"
+
+/**
+ * Names a data member for use in a FieldList.
+ *
+ * \param class_name The class the member belongs to.
+ * \param member The name of the data member.
+ */
+#define ANH_FIELD(class_name, member) \
+    ::anh::Field<class_name, decltype(class_name::member), &class_name::member>
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+/*! \brief Describes one serialized data member of a class.
+ *
+ * Fields are normally named with the ANH_FIELD macro rather than spelled out.
+ */
+template<typename Class, typename T, T Class::*Member>
+struct Field {
+    typedef T type;
+
+    /// Arithmetic and enum fields are copied as raw bytes and can be merged
+    /// with their neighbours, anything else goes through ByteBuffer::write<T>.
+    static const bool is_fixed_size = std::is_arithmetic<T>::value || std::is_enum<T>::value;
+
+    static const T& get(const Class& object) { return object.*Member; }
+    static T& get(Class& object) { return object.*Member; }
+};
+
+/// Compile time totals for a list of fields.
+template<typename... Fields>
+struct FieldListTraits {
+    static const size_t fixed_size = 0;
+    static const bool is_fixed_size = true;
+};
+
+template<typename First, typename... Rest>
+struct FieldListTraits<First, Rest...> {
+    static const size_t fixed_size = (First::is_fixed_size ? sizeof(typename First::type) : 0) +
+        FieldListTraits<Rest...>::fixed_size;
+    static const bool is_fixed_size = First::is_fixed_size && FieldListTraits<Rest...>::is_fixed_size;
+};
+
+/// Walks a list of fields, packing runs of fixed size fields into a scratch
+/// area so each run reaches the buffer as a single write.
+template<typename Class, typename... Fields>
+struct FieldListWalker {
+    static size_t variableSize(const Class&) { return 0; }
+    static void serialize(const Class&, ByteBuffer&, unsigned char*, size_t&) {}
+    static void deserialize(Class&, ByteBuffer&) {}
+    static void deserialize(Class&, ReadCursor&) {}
+};
+
+template<typename Class, typename First, typename... Rest>
+struct FieldListWalker<Class, First, Rest...> {
+    typedef typename First::type FieldType;
+    typedef std::integral_constant<bool, First::is_fixed_size> IsFixedSize;
+
+    static size_t variableSize(const Class& object) {
+        return encodedSize(First::get(object), IsFixedSize()) + FieldListWalker<Class, Rest...>::variableSize(object);
+    }
+
+    static void serialize(const Class& object, ByteBuffer& out, unsigned char* scratch, size_t& pending) {
+        serializeField(First::get(object), out, scratch, pending, IsFixedSize());
+        FieldListWalker<Class, Rest...>::serialize(object, out, scratch, pending);
+    }
+
+    static void deserialize(Class& object, ByteBuffer& in) {
+        deserializeField(First::get(object), in);
+        FieldListWalker<Class, Rest...>::deserialize(object, in);
+    }
+
+    static void deserialize(Class& object, ReadCursor& cursor) {
+        First::get(object) = cursor.get<FieldType>();
+        FieldListWalker<Class, Rest...>::deserialize(object, cursor);
+    }
+
+private:
+    // Fixed size fields are already counted in FieldListTraits::fixed_size and
+    // other types of unknown length are left to the buffer to grow for.
+    template<typename T>
+    static size_t encodedSize(const T&, std::true_type) { return 0; }
+    template<typename T>
+    static size_t encodedSize(const T&, std::false_type) { return 0; }
+    static size_t encodedSize(const std::string& value, std::false_type) {
+        return sizeof(uint16_t) + value.length();
+    }
+    static size_t encodedSize(const std::wstring& value, std::false_type) {
+        return sizeof(uint32_t) + value.length() * 2;
+    }
+
+    static void serializeField(const FieldType& value, ByteBuffer&, unsigned char* scratch,
+        size_t& pending, std::true_type) {
+        std::memcpy(scratch + pending, &value, sizeof(FieldType));
+        pending += sizeof(FieldType);
+    }
+
+    static void serializeField(const FieldType& value, ByteBuffer& out, unsigned char* scratch,
+        size_t& pending, std::false_type) {
+        if (pending) {
+            out.write(scratch, pending);
+            pending = 0;
+        }
+
+        out.write<FieldType>(value);
+    }
+
+    // Strings are read into the existing member so its storage is reused.
+    static void deserializeField(std::string& value, ByteBuffer& in) { in.readString(value); }
+    static void deserializeField(std::wstring& value, ByteBuffer& in) { in.readString(value); }
+
+    template<typename T>
+    static void deserializeField(T& value, ByteBuffer& in) { value = in.read<T>(); }
+};
+
+/*! \brief Generates serialization code for a class from a list of its members.
+ *
+ * Adjacent arithmetic and enum members are packed together and written with a
+ * single copy. When every member is fixed size the whole list is read back
+ * with one bounds check.
+ *
+ * \code
+ * class PositionEvent : public anh::BaseEvent {
+ *     ...
+ * private:
+ *     void onSerialize(anh::ByteBuffer& out) const { Fields::serialize(*this, out); }
+ *     void onDeserialize(anh::ByteBuffer& in) { Fields::deserialize(*this, in); }
+ *
+ *     uint64_t target_;
+ *     float x_, y_, z_;
+ *     std::string zone_;
+ *
+ *     typedef anh::FieldList<PositionEvent,
+ *         ANH_FIELD(PositionEvent, target_),
+ *         ANH_FIELD(PositionEvent, x_),
+ *         ANH_FIELD(PositionEvent, y_),
+ *         ANH_FIELD(PositionEvent, z_),
+ *         ANH_FIELD(PositionEvent, zone_)> Fields;
+ * };
+ * \endcode
+ */
+template<typename Class, typename... Fields>
+struct FieldList {
+    typedef FieldListTraits<Fields...> Traits;
+
+    /// The number of bytes taken up by the fixed size fields.
+    static const size_t fixed_size = Traits::fixed_size;
+
+    /// True if every field is fixed size, making the encoded size constant.
+    static const bool is_fixed_size = Traits::is_fixed_size;
+
+    /**
+     * Writes each field of the object in order, reserving room for all of
+     * them up front so the buffer grows at most once.
+     *
+     * \param object The object to serialize.
+     * \param out The buffer to write to.
+     */
+    static void serialize(const Class& object, ByteBuffer& out) {
+        unsigned char scratch[fixed_size > 0 ? fixed_size : 1];
+        size_t pending = 0;
+
+        out.reserve(out.size() + fixed_size + FieldListWalker<Class, Fields...>::variableSize(object));
+
+        FieldListWalker<Class, Fields...>::serialize(object, out, scratch, pending);
+
+        if (pending) {
+            out.write(scratch, pending);
+        }
+    }
+
+    /**
+     * Reads each field of the object in order.
+     *
+     * \param object The object to deserialize into.
+     * \param in The buffer to read from.
+     * \throws std::out_of_range If the buffer is too short.
+     */
+    static void deserialize(Class& object, ByteBuffer& in) {
+        deserialize(object, in, std::integral_constant<bool, is_fixed_size>());
+    }
+
+private:
+    static void deserialize(Class& object, ByteBuffer& in, std::true_type) {
+        ReadCursor cursor(in);
+        cursor.require(fixed_size);
+
+        FieldListWalker<Class, Fields...>::deserialize(object, cursor);
+    }
+
+    static void deserialize(Class& object, ByteBuffer& in, std::false_type) {
+        FieldListWalker<Class, Fields...>::deserialize(object, in);
+    }
+};
+
+}  // namespace anh
+
+#endif  // ANH_FIELD_LIST_H_
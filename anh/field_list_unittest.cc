@@ -0,0 +1,173 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/field_list.h"
+
+#include <gtest/gtest.h>
+
+#include "anh/event.h"
+
+using anh::BaseEvent;
+using anh::ByteBuffer;
+using anh::EventType;
+
+// Wrapping tests in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+class PositionEvent : public BaseEvent {
+public:
+    PositionEvent()
+        : target_(0), x_(0), y_(0), z_(0), moving_(false) {}
+
+    PositionEvent(uint64_t target, float x, float y, float z, bool moving)
+        : target_(target), x_(x), y_(y), z_(z), moving_(moving) {}
+
+    const EventType& event_type() const { return event_type_; }
+
+    uint64_t target() const { return target_; }
+    float x() const { return x_; }
+    float y() const { return y_; }
+    float z() const { return z_; }
+    bool moving() const { return moving_; }
+
+private:
+    void onSerialize(ByteBuffer& out) const { Fields::serialize(*this, out); }
+    void onDeserialize(ByteBuffer& in) { Fields::deserialize(*this, in); }
+    bool onConsume(bool handled) const { return true; }
+
+    static const EventType event_type_;
+
+    uint64_t target_;
+    float x_, y_, z_;
+    bool moving_;
+
+public:
+    typedef anh::FieldList<PositionEvent,
+        ANH_FIELD(PositionEvent, target_),
+        ANH_FIELD(PositionEvent, x_),
+        ANH_FIELD(PositionEvent, y_),
+        ANH_FIELD(PositionEvent, z_),
+        ANH_FIELD(PositionEvent, moving_)> Fields;
+};
+
+const EventType PositionEvent::event_type_ = EventType("position_event");
+
+struct ChatMessage {
+    uint32_t channel;
+    std::string sender;
+    uint8_t flags;
+    uint16_t language;
+    std::wstring text;
+
+    typedef anh::FieldList<ChatMessage,
+        ANH_FIELD(ChatMessage, channel),
+        ANH_FIELD(ChatMessage, sender),
+        ANH_FIELD(ChatMessage, flags),
+        ANH_FIELD(ChatMessage, language),
+        ANH_FIELD(ChatMessage, text)> Fields;
+};
+
+TEST(FieldListTests, FixedSizeIsComputedAtCompileTime)
+{
+    static_assert(PositionEvent::Fields::is_fixed_size, "PositionEvent should be fixed size");
+    static_assert(PositionEvent::Fields::fixed_size == 8 + 3 * 4 + 1, "Unexpected fixed size");
+
+    static_assert(!ChatMessage::Fields::is_fixed_size, "Strings are not fixed size");
+    static_assert(ChatMessage::Fields::fixed_size == 4 + 1 + 2, "Unexpected fixed size");
+}
+
+TEST(FieldListTests, SerializesFieldsInDeclarationOrder)
+{
+    ChatMessage message;
+    message.channel = 7;
+    message.sender = "someone";
+    message.flags = 3;
+    message.language = 2;
+    message.text = L"hello";
+
+    ByteBuffer buffer;
+    ChatMessage::Fields::serialize(message, buffer);
+
+    // Compare with writing the same fields by hand.
+    ByteBuffer expected;
+    expected.write<uint32_t>(7);
+    expected.write<std::string>(message.sender);
+    expected.write<uint8_t>(3);
+    expected.write<uint16_t>(2);
+    expected.write<std::wstring>(message.text);
+
+    ASSERT_EQ(expected.size(), buffer.size());
+    EXPECT_EQ(0, memcmp(expected.data(), buffer.data(), buffer.size()));
+}
+
+TEST(FieldListTests, ReservesCapacityOnceBeforeWriting)
+{
+    ChatMessage message;
+    message.channel = 7;
+    message.sender = std::string(300, 's');
+    message.flags = 3;
+    message.language = 2;
+    message.text = std::wstring(400, L't');
+
+    ByteBuffer buffer;
+    buffer.write<uint32_t>(0xDEADBABE);
+    ChatMessage::Fields::serialize(message, buffer);
+
+    // Growing while writing would have left spare capacity behind.
+    EXPECT_EQ(sizeof(uint32_t) + ChatMessage::Fields::fixed_size + 2 + 300 + 4 + 800, buffer.size());
+    EXPECT_EQ(buffer.size(), buffer.capacity());
+}
+
+TEST(FieldListTests, CanRoundTripMixedFields)
+{
+    ChatMessage message;
+    message.channel = 42;
+    message.sender = "sender_name";
+    message.flags = 0x81;
+    message.language = 9;
+    message.text = L"some chat text";
+
+    ByteBuffer buffer;
+    ChatMessage::Fields::serialize(message, buffer);
+
+    ChatMessage result;
+    ChatMessage::Fields::deserialize(result, buffer);
+
+    EXPECT_EQ(message.channel, result.channel);
+    EXPECT_EQ(message.sender, result.sender);
+    EXPECT_EQ(message.flags, result.flags);
+    EXPECT_EQ(message.language, result.language);
+    EXPECT_TRUE(message.text == result.text);
+    EXPECT_EQ(buffer.size(), buffer.readPosition());
+}
+
+TEST(FieldListTests, CanRoundTripEvent)
+{
+    PositionEvent event(1234, 1.0f, -2.0f, 3.5f, true);
+
+    ByteBuffer buffer;
+    event.serialize(buffer);
+    EXPECT_EQ(sizeof(uint32_t) + PositionEvent::Fields::fixed_size, buffer.size());
+
+    PositionEvent result;
+    result.deserialize(buffer);
+
+    EXPECT_EQ(uint64_t(1234), result.target());
+    EXPECT_EQ(1.0f, result.x());
+    EXPECT_EQ(-2.0f, result.y());
+    EXPECT_EQ(3.5f, result.z());
+    EXPECT_TRUE(result.moving());
+}
+
+TEST(FieldListTests, DeserializingTruncatedBufferThrowsException)
+{
+    ByteBuffer buffer;
+    buffer.write<uint32_t>(EventType("position_event").ident());
+    buffer.write<uint64_t>(1234);
+
+    PositionEvent result;
+    EXPECT_THROW(result.deserialize(buffer), std::out_of_range);
+}
+
+}  // namespace
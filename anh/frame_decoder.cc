@@ -0,0 +1,126 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/frame_decoder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+void writeFrame(const unsigned char* payload, size_t length, ByteBuffer& out) {
+    if (length > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("Frame too large to encode");
+    }
+
+    LittleEndianWriter(out).write<uint32_t>(static_cast<uint32_t>(length));
+    out.write(payload, length);
+}
+
+FrameDecoder::FrameDecoder(size_t max_frame_size)
+    : max_frame_size_(max_frame_size)
+    , chunk_(nullptr)
+    , chunk_remaining_(0)
+    , partial_complete_(false) {}
+
+void FrameDecoder::feed(const unsigned char* data, size_t length) {
+    if (chunk_remaining_) {
+        throw std::logic_error("Previous chunk has not been fully decoded");
+    }
+
+    chunk_ = data;
+    chunk_remaining_ = length;
+}
+
+bool FrameDecoder::next(FrameView& frame) {
+    // A frame assembled on the previous call has been handed out, its space
+    // can be reused now.
+    if (partial_complete_) {
+        partial_.clear();
+        partial_complete_ = false;
+    }
+
+    if (partial_.size()) {
+        return nextFromPartial(frame);
+    }
+
+    if (chunk_remaining_ < kFrameHeaderSize) {
+        stash(chunk_remaining_);
+        return false;
+    }
+
+    size_t length = readFrameLength(chunk_);
+
+    if (chunk_remaining_ - kFrameHeaderSize < length) {
+        partial_.reserve(kFrameHeaderSize + length);
+        stash(chunk_remaining_);
+        return false;
+    }
+
+    // The whole frame is inside the current chunk, hand out a view of it.
+    frame = FrameView(chunk_ + kFrameHeaderSize, length);
+
+    chunk_ += kFrameHeaderSize + length;
+    chunk_remaining_ -= kFrameHeaderSize + length;
+
+    return true;
+}
+
+size_t FrameDecoder::buffered() const {
+    return partial_complete_ ? 0 : partial_.size();
+}
+
+size_t FrameDecoder::max_frame_size() const {
+    return max_frame_size_;
+}
+
+bool FrameDecoder::nextFromPartial(FrameView& frame) {
+    if (partial_.size() < kFrameHeaderSize) {
+        stash(std::min(kFrameHeaderSize - partial_.size(), chunk_remaining_));
+
+        if (partial_.size() < kFrameHeaderSize) {
+            return false;
+        }
+    }
+
+    size_t length = readFrameLength(partial_.data());
+    size_t frame_size = kFrameHeaderSize + length;
+
+    partial_.reserve(frame_size);
+    stash(std::min(frame_size - partial_.size(), chunk_remaining_));
+
+    if (partial_.size() < frame_size) {
+        return false;
+    }
+
+    frame = FrameView(partial_.data() + kFrameHeaderSize, length);
+    partial_complete_ = true;
+
+    return true;
+}
+
+size_t FrameDecoder::readFrameLength(const unsigned char* header) const {
+    uint32_t length;
+    std::memcpy(&length, header, sizeof(length));
+    length = LittleEndianByteOrder::convert(length);
+
+    if (length > max_frame_size_) {
+        throw std::runtime_error("Frame exceeds maximum size");
+    }
+
+    return length;
+}
+
+void FrameDecoder::stash(size_t length) {
+    partial_.write(chunk_, length);
+
+    chunk_ += length;
+    chunk_remaining_ -= length;
+}
+
+}  // namespace anh
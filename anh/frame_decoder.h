@@ -0,0 +1,118 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#ifndef ANH_FRAME_DECODER_H_
+#define ANH_FRAME_DECODER_H_
+
+#include <cstdint>
+
+#include "anh/byte_buffer.h"
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+/// Size of the little endian uint32 length that precedes every frame.
+const size_t kFrameHeaderSize = sizeof(uint32_t);
+
+/*! \brief A read-only view of one frame's payload.
+ *
+ * The view points either into the chunk passed to FrameDecoder::feed or into
+ * the decoder's own buffer and is only valid until the decoder is next used.
+ */
+class FrameView {
+public:
+    FrameView() : data_(nullptr), length_(0) {}
+    FrameView(const unsigned char* data, size_t length) : data_(data), length_(length) {}
+
+    const unsigned char* data() const { return data_; }
+    size_t length() const { return length_; }
+
+    /// \returns A buffer holding a copy of the payload, for handing to IEvent::deserialize.
+    ByteBuffer copy() const { return ByteBuffer(data_, length_); }
+
+private:
+    const unsigned char* data_;
+    size_t length_;
+};
+
+/**
+ * Appends a payload to a buffer as a length prefixed frame.
+ *
+ * \param payload The start of the payload.
+ * \param length The length of the payload in bytes.
+ * \param out The buffer to write the frame to.
+ */
+void writeFrame(const unsigned char* payload, size_t length, ByteBuffer& out);
+
+/*! \brief Pulls complete length prefixed frames out of a byte stream that
+ * arrives in arbitrary fragments.
+ *
+ * Frames that sit entirely inside the chunk being decoded are returned as
+ * views into that chunk without copying. Only a frame that straddles two
+ * chunks is assembled in the decoder's own buffer.
+ *
+ * \code
+ * while ((received = anh::readFrom(socket, chunk)) > 0) {
+ *     decoder.feed(chunk.data(), chunk.size());
+ *
+ *     anh::FrameView frame;
+ *     while (decoder.next(frame)) {
+ *         dispatch(frame);
+ *     }
+ *
+ *     chunk.clear();
+ * }
+ * \endcode
+ */
+class FrameDecoder {
+public:
+    /// The largest frame accepted unless told otherwise.
+    enum { DEFAULT_MAX_FRAME_SIZE = 1024 * 1024 };
+
+    explicit FrameDecoder(size_t max_frame_size = DEFAULT_MAX_FRAME_SIZE);
+
+    /**
+     * Supplies the next chunk of the stream. The chunk is not copied and must
+     * stay valid until next returns false.
+     *
+     * \throws std::logic_error If the previous chunk has not been fully decoded.
+     */
+    void feed(const unsigned char* data, size_t length);
+
+    /**
+     * Extracts the next complete frame from the stream.
+     *
+     * \param frame Set to the frame's payload, valid until the next call to
+     *      feed or next.
+     * \returns True if a frame was extracted, false once more data is needed.
+     * \throws std::runtime_error If a frame is larger than the maximum frame size,
+     *      after which the stream cannot be decoded further.
+     */
+    bool next(FrameView& frame);
+
+    /// \returns The number of bytes held back from a frame that straddles chunks.
+    size_t buffered() const;
+
+    size_t max_frame_size() const;
+
+private:
+    /// Disable copying, views handed out may point into the decoder.
+    FrameDecoder(const FrameDecoder&);
+    FrameDecoder& operator=(const FrameDecoder&);
+
+    bool nextFromPartial(FrameView& frame);
+    size_t readFrameLength(const unsigned char* header) const;
+    void stash(size_t length);
+
+    size_t max_frame_size_;
+    const unsigned char* chunk_;
+    size_t chunk_remaining_;
+    ByteBuffer partial_;
+    bool partial_complete_;
+};
+
+}  // namespace anh
+
+#endif  // ANH_FRAME_DECODER_H_
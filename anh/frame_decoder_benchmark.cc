@@ -0,0 +1,132 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/frame_decoder.h"
+
+#include <atomic>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <boost/thread.hpp>
+#include <benchmark/benchmark.h>
+
+#include "anh/byte_buffer_io.h"
+
+using anh::ByteBuffer;
+using anh::FrameDecoder;
+using anh::FrameView;
+
+// Wrapping benchmarks in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+// Size of the reads a connection hands to the decoder.
+const size_t kChunkSize = 64 * 1024;
+
+// Builds a stream of frames of the given payload size, long enough that the
+// frames fall at every alignment relative to the chunk boundaries.
+ByteBuffer makeStream(size_t payload_size) {
+    std::vector<unsigned char> payload(payload_size, 0x5A);
+    ByteBuffer stream;
+
+    while (stream.size() < 4 * 1024 * 1024) {
+        anh::writeFrame(payload.data(), payload.size(), stream);
+    }
+
+    return stream;
+}
+
+// Decodes an in memory stream in fixed size chunks, the cost of the decoder
+// on its own.
+void BM_DecodeChunkedStream(benchmark::State& state) {
+    ByteBuffer stream = makeStream(static_cast<size_t>(state.range(0)));
+    size_t frames = 0;
+
+    for (auto _ : state) {
+        FrameDecoder decoder;
+
+        for (size_t offset = 0; offset < stream.size(); offset += kChunkSize) {
+            size_t length = std::min(kChunkSize, stream.size() - offset);
+            decoder.feed(stream.data() + offset, length);
+
+            FrameView frame;
+            while (decoder.next(frame)) {
+                benchmark::DoNotOptimize(frame.data());
+                ++frames;
+            }
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() * stream.size());
+    state.SetItemsProcessed(frames);
+}
+BENCHMARK(BM_DecodeChunkedStream)->Arg(64)->Arg(512)->Arg(4096)->Arg(32768);
+
+// Streams frames through a local socket pair, a writer thread on one end and
+// readFrom feeding the decoder on the other.
+void BM_DecodeLoopbackStream(benchmark::State& state) {
+    ByteBuffer stream = makeStream(static_cast<size_t>(state.range(0)));
+
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+        state.SkipWithError("Unable to create socket pair");
+        return;
+    }
+
+    std::atomic<bool> stop(false);
+    boost::thread writer([&stream, &stop, &sockets] {
+        while (!stop) {
+            size_t offset = 0;
+            while (offset < stream.size() && !stop) {
+                ssize_t sent = send(sockets[0], stream.data() + offset,
+                    stream.size() - offset, MSG_NOSIGNAL);
+                if (sent <= 0) {
+                    return;
+                }
+                offset += sent;
+            }
+        }
+    });
+
+    FrameDecoder decoder;
+    ByteBuffer chunk;
+    chunk.reserve(kChunkSize);
+
+    size_t bytes = 0;
+    size_t frames = 0;
+
+    for (auto _ : state) {
+        chunk.clear();
+
+        ssize_t received = anh::readFrom(sockets[1], chunk);
+        if (received <= 0) {
+            state.SkipWithError("Loopback read failed");
+            break;
+        }
+
+        decoder.feed(chunk.data(), chunk.size());
+
+        FrameView frame;
+        while (decoder.next(frame)) {
+            benchmark::DoNotOptimize(frame.data());
+            ++frames;
+        }
+
+        bytes += received;
+    }
+
+    stop = true;
+    shutdown(sockets[1], SHUT_RDWR);
+    writer.join();
+
+    close(sockets[0]);
+    close(sockets[1]);
+
+    state.SetBytesProcessed(bytes);
+    state.SetItemsProcessed(frames);
+}
+BENCHMARK(BM_DecodeLoopbackStream)->Arg(64)->Arg(4096)->Arg(32768);
+
+}  // namespace
@@ -0,0 +1,152 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/frame_decoder.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using anh::ByteBuffer;
+using anh::FrameDecoder;
+using anh::FrameView;
+
+// Wrapping tests in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+void writeStringFrame(const std::string& payload, ByteBuffer& out) {
+    anh::writeFrame(reinterpret_cast<const unsigned char*>(payload.data()), payload.size(), out);
+}
+
+std::string toString(const FrameView& frame) {
+    return std::string(reinterpret_cast<const char*>(frame.data()), frame.length());
+}
+
+// Feeds the stream in chunks of the given size and collects every frame.
+std::vector<std::string> decodeInChunks(const ByteBuffer& stream, size_t chunk_size) {
+    FrameDecoder decoder;
+    std::vector<std::string> frames;
+
+    for (size_t offset = 0; offset < stream.size(); offset += chunk_size) {
+        // Copy each chunk so a view into a released chunk would be caught.
+        std::vector<unsigned char> chunk(stream.data() + offset,
+            stream.data() + std::min(offset + chunk_size, stream.size()));
+        decoder.feed(chunk.data(), chunk.size());
+
+        FrameView frame;
+        while (decoder.next(frame)) {
+            frames.push_back(toString(frame));
+        }
+    }
+
+    EXPECT_EQ(0u, decoder.buffered());
+    return frames;
+}
+
+TEST(FrameDecoderTests, WritesLittleEndianLengthPrefix)
+{
+    ByteBuffer stream;
+    writeStringFrame("abc", stream);
+
+    ASSERT_EQ(anh::kFrameHeaderSize + 3, stream.size());
+    EXPECT_EQ(3, stream.data()[0]);
+    EXPECT_EQ(0, stream.data()[1]);
+    EXPECT_EQ(0, stream.data()[3]);
+    EXPECT_EQ('a', stream.data()[4]);
+}
+
+TEST(FrameDecoderTests, FramesInsideOneChunkAreNotCopied)
+{
+    ByteBuffer stream;
+    writeStringFrame("first", stream);
+    writeStringFrame("second", stream);
+
+    FrameDecoder decoder;
+    decoder.feed(stream.data(), stream.size());
+
+    FrameView frame;
+    ASSERT_TRUE(decoder.next(frame));
+    EXPECT_EQ(stream.data() + anh::kFrameHeaderSize, frame.data());
+    EXPECT_EQ("first", toString(frame));
+
+    ASSERT_TRUE(decoder.next(frame));
+    EXPECT_EQ(stream.data() + 2 * anh::kFrameHeaderSize + 5, frame.data());
+    EXPECT_EQ("second", toString(frame));
+
+    EXPECT_FALSE(decoder.next(frame));
+    EXPECT_EQ(0u, decoder.buffered());
+}
+
+TEST(FrameDecoderTests, ReassemblesFramesSplitAcrossChunks)
+{
+    std::vector<std::string> payloads;
+    payloads.push_back("a short frame");
+    payloads.push_back("");
+    payloads.push_back(std::string(300, 'x'));
+    payloads.push_back("tail");
+
+    ByteBuffer stream;
+    for (size_t i = 0; i < payloads.size(); ++i) {
+        writeStringFrame(payloads[i], stream);
+    }
+
+    // Every chunk size splits headers and payloads at different points.
+    for (size_t chunk_size = 1; chunk_size <= stream.size(); ++chunk_size) {
+        EXPECT_EQ(payloads, decodeInChunks(stream, chunk_size)) << "chunk size " << chunk_size;
+    }
+}
+
+TEST(FrameDecoderTests, HoldsBackPartialFrames)
+{
+    ByteBuffer stream;
+    writeStringFrame("payload", stream);
+
+    FrameDecoder decoder;
+    decoder.feed(stream.data(), 6);
+
+    FrameView frame;
+    EXPECT_FALSE(decoder.next(frame));
+    EXPECT_EQ(6u, decoder.buffered());
+
+    decoder.feed(stream.data() + 6, stream.size() - 6);
+    ASSERT_TRUE(decoder.next(frame));
+    EXPECT_EQ("payload", toString(frame));
+
+    ByteBuffer copy = frame.copy();
+    EXPECT_EQ(7u, copy.size());
+
+    EXPECT_FALSE(decoder.next(frame));
+    EXPECT_EQ(0u, decoder.buffered());
+}
+
+TEST(FrameDecoderTests, OversizedFrameThrowsException)
+{
+    ByteBuffer stream;
+    writeStringFrame(std::string(65, 'x'), stream);
+
+    FrameDecoder decoder(64);
+    decoder.feed(stream.data(), stream.size());
+
+    FrameView frame;
+    EXPECT_THROW(decoder.next(frame), std::runtime_error);
+}
+
+TEST(FrameDecoderTests, FeedingBeforeDrainingThrowsException)
+{
+    ByteBuffer stream;
+    writeStringFrame("one", stream);
+    writeStringFrame("two", stream);
+
+    FrameDecoder decoder;
+    decoder.feed(stream.data(), stream.size());
+
+    FrameView frame;
+    ASSERT_TRUE(decoder.next(frame));
+
+    EXPECT_THROW(decoder.feed(stream.data(), stream.size()), std::logic_error);
+}
+
+}  // namespace
@@ -8,6 +8,8 @@
 #include <cstdint>
 #include <string>
 
+#include "anh/memcrc.h"
+
 /// The anh namespace hosts a number of useful utility classes intended
 /// to be used and reused in domain specific classes.
 namespace anh {
@@ -24,8 +26,14 @@ std::ostream& operator<<(std::ostream& message, const HashString& string);
 
 static const char* const kWildCardHashString = "*";
 
+/// The ident of kWildCardHashString.
+static const uint32_t kWildCardHashIdent = memcrcConstant("*");
+
 /*! \brief This class provides a utility for generating identifiers that are
  * easy to read and can be used as key values in the standard associative containers.
+ *
+ * The ident of a HashString is the memcrc of its string, so idents of string
+ * literals are also available during compilation through memcrcConstant.
  */
 class HashString {
 public:
@@ -56,4 +56,29 @@ TEST(HashStringTests, CanUseHashStringAsContainerKey) {
     EXPECT_EQ(2000, it->second);
 }
 
+/// Idents of string literals are available during compilation.
+static_assert(anh::memcrcConstant("test_hash_string") == 0x107D0089, "Compile time ident differs");
+static_assert(anh::memcrcConstant("mock_event") == 0xC3CEA198, "Compile time ident differs");
+
+/// This test shows how compile time idents match the idents of HashStrings.
+TEST(HashStringTests, CompileTimeIdentsMatchRuntimeIdents) {
+    EXPECT_EQ(HashString("test_hash_string").ident(), anh::memcrcConstant("test_hash_string"));
+    EXPECT_EQ(HashString(anh::kWildCardHashString).ident(), anh::kWildCardHashIdent);
+    EXPECT_EQ(HashString("").ident(), anh::memcrcConstant(""));
+}
+
+/// This test shows how to switch on the ident of a HashString.
+TEST(HashStringTests, CanSwitchOnIdents) {
+    HashString hash_string("my_key2");
+
+    int matched = 0;
+    switch (hash_string.ident()) {
+        case anh::memcrcConstant("my_key1"): matched = 1; break;
+        case anh::memcrcConstant("my_key2"): matched = 2; break;
+        case anh::memcrcConstant("my_key3"): matched = 3; break;
+    }
+
+    EXPECT_EQ(2, matched);
+}
+
 }  // namespace
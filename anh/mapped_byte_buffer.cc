@@ -0,0 +1,231 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/mapped_byte_buffer.h"
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+namespace {
+
+void throwSystemError(const std::string& what, const std::string& path, int error) {
+    throw std::runtime_error(what + " " + path + ": " + strerror(error));
+}
+
+int adviceFor(MappedByteBuffer::AccessPattern pattern) {
+    switch (pattern) {
+        case MappedByteBuffer::ACCESS_SEQUENTIAL: return MADV_SEQUENTIAL;
+        case MappedByteBuffer::ACCESS_RANDOM: return MADV_RANDOM;
+        default: return MADV_NORMAL;
+    }
+}
+
+}  // namespace
+
+MappedByteBuffer::MappedByteBuffer(const std::string& path, Mode mode,
+    AccessPattern pattern, size_t growth_chunk)
+    : path_(path)
+    , mode_(mode)
+    , pattern_(pattern)
+    , file_(-1)
+    , data_(nullptr)
+    , size_(0)
+    , capacity_(0)
+    , growth_chunk_(growth_chunk ? growth_chunk : static_cast<size_t>(DEFAULT_GROWTH_CHUNK))
+    , read_position_(0)
+    , write_position_(0) {
+    if (mode_ == CREATE) {
+        file_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    } else {
+        file_ = ::open(path.c_str(), O_RDONLY);
+    }
+
+    if (file_ < 0) {
+        throwSystemError("Unable to open", path, errno);
+    }
+
+    if (mode_ == CREATE) {
+        // Writable mappings start empty and grow on the first write.
+        return;
+    }
+
+    struct stat info;
+    if (fstat(file_, &info) != 0) {
+        int error = errno;
+        close();
+        throwSystemError("Unable to stat", path, error);
+    }
+
+    size_ = static_cast<size_t>(info.st_size);
+    capacity_ = size_;
+
+    // Zero length mappings are not allowed, an empty file simply has no data.
+    if (size_ == 0) {
+        return;
+    }
+
+    void* mapping = mmap(nullptr, capacity_, PROT_READ, MAP_SHARED, file_, 0);
+    if (mapping == MAP_FAILED) {
+        int error = errno;
+        close();
+        throwSystemError("Unable to map", path, error);
+    }
+
+    data_ = static_cast<unsigned char*>(mapping);
+    madvise(data_, capacity_, adviceFor(pattern_));
+}
+
+MappedByteBuffer::~MappedByteBuffer() {
+    close();
+}
+
+StringView MappedByteBuffer::readStringView(bool doSwapEndian) {
+    uint16_t length = peek<uint16_t>(doSwapEndian);
+    checkRead(read_position_ + sizeof(uint16_t), length);
+
+    StringView view(reinterpret_cast<const char*>(data_ + read_position_ + sizeof(uint16_t)), length);
+    read_position_ += sizeof(uint16_t) + length;
+
+    return view;
+}
+
+void MappedByteBuffer::write(const unsigned char* data, size_t size) {
+    if (mode_ != CREATE) {
+        throw std::logic_error("Cannot write to a read only mapping");
+    }
+
+    if (capacity_ - write_position_ < size) {
+        grow(write_position_ + size);
+    }
+
+    if (size) {
+        std::memcpy(data_ + write_position_, data, size);
+    }
+
+    write_position_ += size;
+
+    if (size_ < write_position_) {
+        size_ = write_position_;
+    }
+}
+
+void MappedByteBuffer::willNeed(size_t offset, size_t length) {
+    if (offset >= capacity_) {
+        return;
+    }
+
+    // madvise needs a page aligned start address.
+    size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t aligned = offset - (offset % page_size);
+
+    if (length > capacity_ - offset) {
+        length = capacity_ - offset;
+    }
+
+    madvise(data_ + aligned, length + (offset - aligned), MADV_WILLNEED);
+}
+
+void MappedByteBuffer::sync() {
+    if (data_ && mode_ == CREATE && msync(data_, capacity_, MS_SYNC) != 0) {
+        throwSystemError("Unable to sync", path_, errno);
+    }
+}
+
+size_t MappedByteBuffer::readPosition() const {
+    return read_position_;
+}
+
+void MappedByteBuffer::readPosition(size_t position) {
+    read_position_ = position;
+}
+
+size_t MappedByteBuffer::writePosition() const {
+    return write_position_;
+}
+
+size_t MappedByteBuffer::size() const {
+    return size_;
+}
+
+size_t MappedByteBuffer::capacity() const {
+    return capacity_;
+}
+
+const unsigned char* MappedByteBuffer::data() const {
+    return data_;
+}
+
+void MappedByteBuffer::checkRead(size_t offset, size_t length) const {
+    if (size_ < offset || size_ - offset < length) {
+        throw std::out_of_range("Read past end of buffer");
+    }
+}
+
+void MappedByteBuffer::grow(size_t required) {
+    // Round up to a whole number of chunks so the file is extended rarely.
+    size_t capacity = ((required / growth_chunk_) + 1) * growth_chunk_;
+
+    if (ftruncate(file_, static_cast<off_t>(capacity)) != 0) {
+        throwSystemError("Unable to grow", path_, errno);
+    }
+
+    void* mapping;
+
+#ifdef __linux__
+    if (data_) {
+        mapping = mremap(data_, capacity_, capacity, MREMAP_MAYMOVE);
+    } else {
+        mapping = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, file_, 0);
+    }
+#else
+    if (data_) {
+        munmap(data_, capacity_);
+        data_ = nullptr;
+        capacity_ = 0;
+    }
+
+    mapping = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, file_, 0);
+#endif
+
+    if (mapping == MAP_FAILED) {
+        throwSystemError("Unable to map", path_, errno);
+    }
+
+    data_ = static_cast<unsigned char*>(mapping);
+    capacity_ = capacity;
+
+    // A new or moved mapping starts with default advice.
+    madvise(data_, capacity_, adviceFor(pattern_));
+}
+
+void MappedByteBuffer::close() {
+    if (data_) {
+        munmap(data_, capacity_);
+        data_ = nullptr;
+    }
+
+    if (file_ >= 0) {
+        if (mode_ == CREATE) {
+            // Drop the unused tail of the last growth chunk. A failure here
+            // only leaves padding at the end of the file, no data is lost.
+            int result = ftruncate(file_, static_cast<off_t>(size_));
+            static_cast<void>(result);
+        }
+
+        ::close(file_);
+        file_ = -1;
+    }
+
+    capacity_ = 0;
+}
+
+}  // namespace anh
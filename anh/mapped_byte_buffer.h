@@ -0,0 +1,225 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#ifndef ANH_MAPPED_BYTE_BUFFER_H_
+#define ANH_MAPPED_BYTE_BUFFER_H_
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "anh/byte_buffer.h"
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+/*! \brief A file mapped into memory and accessed with the ByteBuffer interface.
+ *
+ * Reading a large snapshot through a mapping pages it in on demand instead of
+ * copying the whole file onto the heap first. In CREATE mode the file grows in
+ * chunks as data is written and is trimmed to the bytes written on close.
+ *
+ * \code
+ * anh::MappedByteBuffer snapshot("world.snapshot");
+ *
+ * uint32_t object_count = snapshot.read<uint32_t>();
+ * ...
+ * \endcode
+ *
+ * \note Only available on POSIX systems.
+ *
+ * Values are read in the same layouts ByteBuffer uses: fixed size arithmetic
+ * and enum values, arrays of them, length prefixed strings and varints.
+ *
+ * \note MappedByteBuffer is not a ByteBuffer, so it cannot be handed to
+ * IEvent::serialize or deserialize, ReadCursor, FieldList or FrameDecoder.
+ * Events stored in a snapshot are read by copying their bytes into a
+ * ByteBuffer, e.g. from a readStringView, or by reading their fields from the
+ * mapping directly.
+ */
+class MappedByteBuffer {
+public:
+    enum Mode {
+        READ_ONLY,  ///< Maps an existing file for reading.
+        CREATE      ///< Creates or truncates a file and maps it for writing.
+    };
+
+    /// Hints passed to the kernel about how the mapping will be read.
+    enum AccessPattern {
+        ACCESS_NORMAL,
+        ACCESS_SEQUENTIAL,
+        ACCESS_RANDOM
+    };
+
+    /// The default number of bytes a CREATE mapping grows the file by.
+    enum { DEFAULT_GROWTH_CHUNK = 16 * 1024 * 1024 };
+
+    /**
+     * Opens and maps a file.
+     *
+     * \param path The file to map.
+     * \param mode Whether to map an existing file or create a new one.
+     * \param pattern The access pattern hint given to the kernel, applied to
+     *      the initial mapping and again each time a CREATE mapping grows.
+     * \param growth_chunk The number of bytes to grow a CREATE mapping by.
+     * \throws std::runtime_error If the file cannot be opened or mapped.
+     */
+    explicit MappedByteBuffer(const std::string& path, Mode mode = READ_ONLY,
+        AccessPattern pattern = ACCESS_SEQUENTIAL, size_t growth_chunk = DEFAULT_GROWTH_CHUNK);
+
+    /// Unmaps and closes the file, trimming a CREATE file to the bytes written.
+    ~MappedByteBuffer();
+
+    template<typename T> const T peekAt(size_t offset, bool doSwapEndian = false) const;
+    template<typename T> const T peek(bool doSwapEndian = false) const;
+    template<typename T> const T read(bool doSwapEndian = false);
+    template<typename T> void readArray(T* data, size_t count, bool doSwapEndian = false);
+
+    /// \see ByteBuffer::readVarint
+    template<typename T> const T readVarint();
+
+    /// \see ByteBuffer::readStringView
+    StringView readStringView(bool doSwapEndian = false);
+
+    /// Writes a fixed size value at the write position, growing the file as needed.
+    template<typename T> MappedByteBuffer& write(const T& data);
+    template<typename T> MappedByteBuffer& writeArray(const T* data, size_t count);
+    void write(const unsigned char* data, size_t size);
+
+    /**
+     * Asks the kernel to start reading a region in ahead of use.
+     *
+     * \param offset The start of the region.
+     * \param length The length of the region in bytes.
+     */
+    void willNeed(size_t offset, size_t length);
+
+    /// Flushes written pages to the file.
+    void sync();
+
+    size_t readPosition() const;
+    void readPosition(size_t position);
+
+    size_t writePosition() const;
+
+    /// \returns The number of readable bytes, for CREATE mappings the bytes written.
+    size_t size() const;
+
+    /// \returns The number of bytes currently mapped.
+    size_t capacity() const;
+
+    const unsigned char* data() const;
+
+private:
+    /// Disable copying, each mapping owns its file descriptor.
+    MappedByteBuffer(const MappedByteBuffer&);
+    MappedByteBuffer& operator=(const MappedByteBuffer&);
+
+    void checkRead(size_t offset, size_t length) const;
+    void grow(size_t required);
+    void close();
+
+    std::string path_;
+    Mode mode_;
+    AccessPattern pattern_;
+    int file_;
+    unsigned char* data_;
+    size_t size_;
+    size_t capacity_;
+    size_t growth_chunk_;
+    size_t read_position_;
+    size_t write_position_;
+};
+
+template<typename T>
+const T MappedByteBuffer::peekAt(size_t offset, bool doSwapEndian) const {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+        "Only fixed size values can be read from a mapped buffer");
+
+    checkRead(offset, sizeof(T));
+
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type bytes;
+    std::memcpy(&bytes, data_ + offset, sizeof(T));
+
+    if (doSwapEndian) {
+        ByteSwapper<T>::swapBytes(reinterpret_cast<unsigned char*>(&bytes));
+    }
+
+    return *reinterpret_cast<const T*>(&bytes);
+}
+
+template<typename T>
+const T MappedByteBuffer::peek(bool doSwapEndian) const {
+    return peekAt<T>(read_position_, doSwapEndian);
+}
+
+template<typename T>
+const T MappedByteBuffer::read(bool doSwapEndian) {
+    T data = peekAt<T>(read_position_, doSwapEndian);
+    read_position_ += sizeof(T);
+    return data;
+}
+
+template<typename T>
+void MappedByteBuffer::readArray(T* data, size_t count, bool doSwapEndian) {
+    static_assert(std::is_arithmetic<T>::value, "Only arrays of arithmetic types can be read");
+
+    if (size_ < read_position_ || (size_ - read_position_) / sizeof(T) < count) {
+        throw std::out_of_range("Read past end of buffer");
+    }
+
+    if (count == 0) {
+        return;
+    }
+
+    std::memcpy(data, data_ + read_position_, count * sizeof(T));
+
+    if (doSwapEndian && sizeof(T) > 1) {
+        ByteBuffer::swapEndianArray(reinterpret_cast<unsigned char*>(data), sizeof(T), count);
+    }
+
+    read_position_ += count * sizeof(T);
+}
+
+/// Reads a length prefixed string, as ByteBuffer::read<std::string> does.
+template<>
+inline const std::string MappedByteBuffer::read<std::string>(bool doSwapEndian) {
+    return readStringView(doSwapEndian).str();
+}
+
+template<typename T>
+const T MappedByteBuffer::readVarint() {
+    size_t available = (size_ > read_position_) ? size_ - read_position_ : 0;
+    size_t length = 0;
+
+    T value = ByteBuffer::narrowVarint<T>(
+        ByteBuffer::decodeUnsignedVarint(data_ + (available ? read_position_ : 0), available, &length));
+    read_position_ += length;
+
+    return value;
+}
+
+template<typename T>
+MappedByteBuffer& MappedByteBuffer::write(const T& data) {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+        "Only fixed size values can be written to a mapped buffer");
+
+    write(reinterpret_cast<const unsigned char*>(&data), sizeof(T));
+    return *this;
+}
+
+template<typename T>
+MappedByteBuffer& MappedByteBuffer::writeArray(const T* data, size_t count) {
+    static_assert(std::is_arithmetic<T>::value, "Only arrays of arithmetic types can be written");
+
+    write(reinterpret_cast<const unsigned char*>(data), count * sizeof(T));
+    return *this;
+}
+
+}  // namespace anh
+
+#endif  // ANH_MAPPED_BYTE_BUFFER_H_
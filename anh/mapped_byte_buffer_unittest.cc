@@ -0,0 +1,153 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/mapped_byte_buffer.h"
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using anh::ByteBuffer;
+using anh::MappedByteBuffer;
+
+// Wrapping tests in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+class MappedByteBufferTests : public testing::Test {
+protected:
+    void SetUp() {
+        path_ = testing::TempDir() + "anh_mapped_byte_buffer_test.bin";
+    }
+
+    void TearDown() {
+        std::remove(path_.c_str());
+    }
+
+    void writeFile(const ByteBuffer& buffer) {
+        std::ofstream file(path_.c_str(), std::ios::binary);
+        file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    }
+
+    size_t fileSize() {
+        std::ifstream file(path_.c_str(), std::ios::binary | std::ios::ate);
+        return static_cast<size_t>(file.tellg());
+    }
+
+    std::string path_;
+};
+
+TEST_F(MappedByteBufferTests, CanReadValuesFromMappedFile)
+{
+    ByteBuffer buffer;
+    buffer.write<uint32_t>(3);
+    buffer.write<std::string>(std::string("snapshot"));
+    buffer.write<uint64_t>(0x0102030405060708ULL);
+    writeFile(buffer);
+
+    MappedByteBuffer mapped(path_);
+    EXPECT_EQ(buffer.size(), mapped.size());
+
+    EXPECT_EQ(uint32_t(3), mapped.read<uint32_t>());
+    EXPECT_EQ(std::string("snapshot"), mapped.readStringView().str());
+    EXPECT_EQ(uint64_t(0x0807060504030201ULL), mapped.peek<uint64_t>(true));
+    EXPECT_EQ(uint64_t(0x0102030405060708ULL), mapped.read<uint64_t>());
+    EXPECT_THROW(mapped.read<uint8_t>(), std::out_of_range);
+}
+
+TEST_F(MappedByteBufferTests, CanReadStringsAndVarintsLikeByteBuffer)
+{
+    ByteBuffer buffer;
+    buffer.write<std::string>(std::string("zone"));
+    buffer.writeVarint<uint32_t>(300);
+    buffer.writeVarint<int64_t>(-70000);
+    writeFile(buffer);
+
+    MappedByteBuffer mapped(path_);
+
+    EXPECT_EQ(std::string("zone"), mapped.read<std::string>());
+    EXPECT_THROW(mapped.readVarint<uint8_t>(), std::overflow_error);
+    EXPECT_EQ(uint32_t(300), mapped.readVarint<uint32_t>());
+    EXPECT_EQ(-70000, mapped.readVarint<int64_t>());
+    EXPECT_EQ(mapped.size(), mapped.readPosition());
+    EXPECT_THROW(mapped.readVarint<uint32_t>(), std::out_of_range);
+}
+
+TEST_F(MappedByteBufferTests, EmptyFileHasNoData)
+{
+    writeFile(ByteBuffer());
+
+    MappedByteBuffer mapped(path_);
+    EXPECT_EQ(uint32_t(0), mapped.size());
+    EXPECT_THROW(mapped.read<int>(), std::out_of_range);
+}
+
+TEST_F(MappedByteBufferTests, OpeningMissingFileThrowsException)
+{
+    EXPECT_THROW(MappedByteBuffer(path_ + ".missing"), std::runtime_error);
+}
+
+TEST_F(MappedByteBufferTests, WritingToReadOnlyMappingThrowsException)
+{
+    ByteBuffer buffer;
+    buffer.write<int>(1);
+    writeFile(buffer);
+
+    MappedByteBuffer mapped(path_);
+    EXPECT_THROW(mapped.write<int>(2), std::logic_error);
+}
+
+TEST_F(MappedByteBufferTests, CreatedFileGrowsInChunksAndIsTrimmedOnClose)
+{
+    std::vector<uint32_t> values(10000);
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = static_cast<uint32_t>(i * 7);
+    }
+
+    {
+        MappedByteBuffer mapped(path_, MappedByteBuffer::CREATE,
+            MappedByteBuffer::ACCESS_SEQUENTIAL, 4096);
+
+        mapped.write<uint32_t>(static_cast<uint32_t>(values.size()));
+        mapped.writeArray(&values[0], values.size());
+
+        EXPECT_EQ(sizeof(uint32_t) * (values.size() + 1), mapped.size());
+        EXPECT_EQ(uint32_t(0), mapped.capacity() % 4096);
+
+        // Data written so far can be read back before closing.
+        EXPECT_EQ(uint32_t(10000), mapped.read<uint32_t>());
+    }
+
+    EXPECT_EQ(sizeof(uint32_t) * (values.size() + 1), fileSize());
+
+    MappedByteBuffer mapped(path_, MappedByteBuffer::READ_ONLY, MappedByteBuffer::ACCESS_RANDOM);
+    mapped.willNeed(0, mapped.size());
+
+    EXPECT_EQ(uint32_t(10000), mapped.read<uint32_t>());
+
+    std::vector<uint32_t> result(values.size());
+    mapped.readArray(&result[0], result.size());
+    EXPECT_EQ(values, result);
+}
+
+TEST_F(MappedByteBufferTests, CanReadSwappedArrays)
+{
+    ByteBuffer buffer;
+    for (uint32_t i = 0; i < 100; ++i) {
+        anh::BigEndianWriter(buffer).write<uint32_t>(i * 0x01020304u);
+    }
+    writeFile(buffer);
+
+    MappedByteBuffer mapped(path_);
+
+    std::vector<uint32_t> result(100);
+    mapped.readArray(&result[0], result.size(), true);
+
+    for (uint32_t i = 0; i < 100; ++i) {
+        EXPECT_EQ(i * 0x01020304u, result[i]);
+    }
+}
+
+}  // namespace
@@ -4,80 +4,303 @@
 
 #include "anh/memcrc.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <vector>
 
+#include <boost/thread.hpp>
+
+// On x86 with gcc large buffers are folded with PCLMULQDQ when the processor
+// has it, everything else uses the sliced tables.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ANH_MEMCRC_CLMUL 1
+#include <immintrin.h>
+#endif
+
 /// The anh namespace hosts a number of useful utility classes intended
 /// to be used and reused in domain specific classes.
 namespace anh {
 
-const uint32_t kCrcTable[256] = {
-    0x0000000,
-    0x04C11DB7, 0x09823B6E, 0x0D4326D9, 0x130476DC, 0x17C56B6B,
-    0x1A864DB2, 0x1E475005, 0x2608EDB8, 0x22C9F00F, 0x2F8AD6D6,
-    0x2B4BCB61, 0x350C9B64, 0x31CD86D3, 0x3C8EA00A, 0x384FBDBD,
-    0x4C11DB70, 0x48D0C6C7, 0x4593E01E, 0x4152FDA9, 0x5F15ADAC,
-    0x5BD4B01B, 0x569796C2, 0x52568B75, 0x6A1936C8, 0x6ED82B7F,
-    0x639B0DA6, 0x675A1011, 0x791D4014, 0x7DDC5DA3, 0x709F7B7A,
-    0x745E66CD, 0x9823B6E0, 0x9CE2AB57, 0x91A18D8E, 0x95609039,
-    0x8B27C03C, 0x8FE6DD8B, 0x82A5FB52, 0x8664E6E5, 0xBE2B5B58,
-    0xBAEA46EF, 0xB7A96036, 0xB3687D81, 0xAD2F2D84, 0xA9EE3033,
-    0xA4AD16EA, 0xA06C0B5D, 0xD4326D90, 0xD0F37027, 0xDDB056FE,
-    0xD9714B49, 0xC7361B4C, 0xC3F706FB, 0xCEB42022, 0xCA753D95,
-    0xF23A8028, 0xF6FB9D9F, 0xFBB8BB46, 0xFF79A6F1, 0xE13EF6F4,
-    0xE5FFEB43, 0xE8BCCD9A, 0xEC7DD02D, 0x34867077, 0x30476DC0,
-    0x3D044B19, 0x39C556AE, 0x278206AB, 0x23431B1C, 0x2E003DC5,
-    0x2AC12072, 0x128E9DCF, 0x164F8078, 0x1B0CA6A1, 0x1FCDBB16,
-    0x018AEB13, 0x054BF6A4, 0x0808D07D, 0x0CC9CDCA, 0x7897AB07,
-    0x7C56B6B0, 0x71159069, 0x75D48DDE, 0x6B93DDDB, 0x6F52C06C,
-    0x6211E6B5, 0x66D0FB02, 0x5E9F46BF, 0x5A5E5B08, 0x571D7DD1,
-    0x53DC6066, 0x4D9B3063, 0x495A2DD4, 0x44190B0D, 0x40D816BA,
-    0xACA5C697, 0xA864DB20, 0xA527FDF9, 0xA1E6E04E, 0xBFA1B04B,
-    0xBB60ADFC, 0xB6238B25, 0xB2E29692, 0x8AAD2B2F, 0x8E6C3698,
-    0x832F1041, 0x87EE0DF6, 0x99A95DF3, 0x9D684044, 0x902B669D,
-    0x94EA7B2A, 0xE0B41DE7, 0xE4750050, 0xE9362689, 0xEDF73B3E,
-    0xF3B06B3B, 0xF771768C, 0xFA325055, 0xFEF34DE2, 0xC6BCF05F,
-    0xC27DEDE8, 0xCF3ECB31, 0xCBFFD686, 0xD5B88683, 0xD1799B34,
-    0xDC3ABDED, 0xD8FBA05A, 0x690CE0EE, 0x6DCDFD59, 0x608EDB80,
-    0x644FC637, 0x7A089632, 0x7EC98B85, 0x738AAD5C, 0x774BB0EB,
-    0x4F040D56, 0x4BC510E1, 0x46863638, 0x42472B8F, 0x5C007B8A,
-    0x58C1663D, 0x558240E4, 0x51435D53, 0x251D3B9E, 0x21DC2629,
-    0x2C9F00F0, 0x285E1D47, 0x36194D42, 0x32D850F5, 0x3F9B762C,
-    0x3B5A6B9B, 0x0315D626, 0x07D4CB91, 0x0A97ED48, 0x0E56F0FF,
-    0x1011A0FA, 0x14D0BD4D, 0x19939B94, 0x1D528623, 0xF12F560E,
-    0xF5EE4BB9, 0xF8AD6D60, 0xFC6C70D7, 0xE22B20D2, 0xE6EA3D65,
-    0xEBA91BBC, 0xEF68060B, 0xD727BBB6, 0xD3E6A601, 0xDEA580D8,
-    0xDA649D6F, 0xC423CD6A, 0xC0E2D0DD, 0xCDA1F604, 0xC960EBB3,
-    0xBD3E8D7E, 0xB9FF90C9, 0xB4BCB610, 0xB07DABA7, 0xAE3AFBA2,
-    0xAAFBE615, 0xA7B8C0CC, 0xA379DD7B, 0x9B3660C6, 0x9FF77D71,
-    0x92B45BA8, 0x9675461F, 0x8832161A, 0x8CF30BAD, 0x81B02D74,
-    0x857130C3, 0x5D8A9099, 0x594B8D2E, 0x5408ABF7, 0x50C9B640,
-    0x4E8EE645, 0x4A4FFBF2, 0x470CDD2B, 0x43CDC09C, 0x7B827D21,
-    0x7F436096, 0x7200464F, 0x76C15BF8, 0x68860BFD, 0x6C47164A,
-    0x61043093, 0x65C52D24, 0x119B4BE9, 0x155A565E, 0x18197087,
-    0x1CD86D30, 0x029F3D35, 0x065E2082, 0x0B1D065B, 0x0FDC1BEC,
-    0x3793A651, 0x3352BBE6, 0x3E119D3F, 0x3AD08088, 0x2497D08D,
-    0x2056CD3A, 0x2D15EBE3, 0x29D4F654, 0xC5A92679, 0xC1683BCE,
-    0xCC2B1D17, 0xC8EA00A0, 0xD6AD50A5, 0xD26C4D12, 0xDF2F6BCB,
-    0xDBEE767C, 0xE3A1CBC1, 0xE760D676, 0xEA23F0AF, 0xEEE2ED18,
-    0xF0A5BD1D, 0xF464A0AA, 0xF9278673, 0xFDE69BC4, 0x89B8FD09,
-    0x8D79E0BE, 0x803AC667, 0x84FBDBD0, 0x9ABC8BD5, 0x9E7D9662,
-    0x933EB0BB, 0x97FFAD0C, 0xAFB010B1, 0xAB710D06, 0xA6322BDF,
-    0xA2F33668, 0xBCB4666D, 0xB8757BDA, 0xB5365D03, 0xB1F740B4,
+namespace {
+
+// Slicing-by-8 consumes eight bytes per step using eight tables, where table k
+// holds the checksum contribution of a byte followed by k zero bytes.
+const size_t kCrcSliceCount = 8;
+
+typedef MakeCrcByteList<256>::type AllBytes;
+
+constexpr CrcSlice kCrcSlices[kCrcSliceCount] = {
+    makeCrcSlice<0>(AllBytes()), makeCrcSlice<1>(AllBytes()),
+    makeCrcSlice<2>(AllBytes()), makeCrcSlice<3>(AllBytes()),
+    makeCrcSlice<4>(AllBytes()), makeCrcSlice<5>(AllBytes()),
+    makeCrcSlice<6>(AllBytes()), makeCrcSlice<7>(AllBytes()),
 };
 
-uint32_t memcrc(char const * const source_string, uint32_t length) {
-    uint32_t crc = 0xffffffff;  // starting seed
-    for (uint32_t i = 0; i < length; ++i) {
-        crc = kCrcTable[source_string[i] ^ (crc >> 24)] ^ (crc << 8);
-    }
+// The first slice is the classic byte at a time table.
+static_assert(kCrcSlices[0].entries[1] == 0x04C11DB7, "Unexpected crc table entry");
+static_assert(kCrcSlices[0].entries[128] == 0x690CE0EE, "Unexpected crc table entry");
+static_assert(kCrcSlices[0].entries[255] == 0xB1F740B4, "Unexpected crc table entry");
+static_assert(kCrcSlices[0].entries[255] == kCrcTable.entries[255], "Unexpected crc table entry");
 
-    return ~crc;
+}  // namespace
+
+uint32_t memcrc(char const * const source_string, size_t length) {
+    return ~memcrcUpdate(kCrcSeed, reinterpret_cast<const unsigned char*>(source_string), length);
 }
 
 uint32_t memcrc(const std::string& source_string) {
     return memcrc(source_string.c_str(), source_string.length());
 }
 
+#ifdef ANH_MEMCRC_CLMUL
+
+namespace {
+
+// Folding constants x^n mod P: each 128 bit lane is carried forward 512 bits
+// in the main loop and 128 bits when the lanes are combined, with the high
+// half of a lane 64 bits further along than its low half.
+const uint64_t kFold512Low = 0xE6228B11;   // x^512 mod P
+const uint64_t kFold512High = 0x8833794C;  // x^576 mod P
+const uint64_t kFold128Low = 0xE8A45605;   // x^128 mod P
+const uint64_t kFold128High = 0xC5B9CD4C;  // x^192 mod P
+
+// The checksum runs most significant bit first, so blocks are byte reversed
+// to put the first bit of a block in the top bit of the register.
+__attribute__((target("pclmul,ssse3")))
+inline __m128i loadBlock(const unsigned char* data, __m128i reverse) {
+    return _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), reverse);
+}
+
+__attribute__((target("pclmul,ssse3")))
+inline __m128i fold(__m128i lane, __m128i constants) {
+    return _mm_xor_si128(_mm_clmulepi64_si128(lane, constants, 0x11),
+        _mm_clmulepi64_si128(lane, constants, 0x00));
+}
+
+}  // namespace
+
+__attribute__((target("pclmul,ssse3")))
+uint32_t memcrcUpdateClmul(uint32_t crc, const unsigned char* data, size_t length) {
+    if (length < 64) {
+        return memcrcUpdatePortable(crc, data, length);
+    }
+
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    __m128i lane0 = loadBlock(data, reverse);
+    __m128i lane1 = loadBlock(data + 16, reverse);
+    __m128i lane2 = loadBlock(data + 32, reverse);
+    __m128i lane3 = loadBlock(data + 48, reverse);
+
+    // Starting from a running value is the same as starting from zero with
+    // the value added to the first 32 bits of the data.
+    lane0 = _mm_xor_si128(lane0, _mm_set_epi32(static_cast<int>(crc), 0, 0, 0));
+
+    data += 64;
+    length -= 64;
+
+    const __m128i fold512 = _mm_set_epi64x(kFold512High, kFold512Low);
+
+    while (length >= 64) {
+        lane0 = _mm_xor_si128(fold(lane0, fold512), loadBlock(data, reverse));
+        lane1 = _mm_xor_si128(fold(lane1, fold512), loadBlock(data + 16, reverse));
+        lane2 = _mm_xor_si128(fold(lane2, fold512), loadBlock(data + 32, reverse));
+        lane3 = _mm_xor_si128(fold(lane3, fold512), loadBlock(data + 48, reverse));
+
+        data += 64;
+        length -= 64;
+    }
+
+    const __m128i fold128 = _mm_set_epi64x(kFold128High, kFold128Low);
+
+    __m128i folded = _mm_xor_si128(fold(lane0, fold128), lane1);
+    folded = _mm_xor_si128(fold(folded, fold128), lane2);
+    folded = _mm_xor_si128(fold(folded, fold128), lane3);
+
+    while (length >= 16) {
+        folded = _mm_xor_si128(fold(folded, fold128), loadBlock(data, reverse));
+
+        data += 16;
+        length -= 16;
+    }
+
+    // The folded block leaves the same remainder as everything before it, so
+    // the tables finish the job from a zero start.
+    unsigned char block[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(block), _mm_shuffle_epi8(folded, reverse));
+
+    crc = memcrcUpdatePortable(0, block, sizeof(block));
+    return memcrcUpdatePortable(crc, data, length);
+}
+
+bool memcrcClmulSupported() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+}
+
+#else
+
+uint32_t memcrcUpdateClmul(uint32_t crc, const unsigned char* data, size_t length) {
+    return memcrcUpdatePortable(crc, data, length);
+}
+
+bool memcrcClmulSupported() {
+    return false;
+}
+
+#endif  // ANH_MEMCRC_CLMUL
+
+namespace {
+
+typedef uint32_t (*CrcKernel)(uint32_t crc, const unsigned char* data, size_t length);
+
+CrcKernel selectCrcKernel() {
+    return memcrcClmulSupported() ? memcrcUpdateClmul : memcrcUpdatePortable;
+}
+
+}  // namespace
+
+uint32_t memcrcUpdate(uint32_t crc, const unsigned char* data, size_t length) {
+    // Short strings such as HashString names are never folded, so skip the
+    // indirect call for them.
+    if (length < 64) {
+        return memcrcUpdatePortable(crc, data, length);
+    }
+
+    // Chosen on first use rather than by a global initializer, since global
+    // HashStrings in other files may be constructed first.
+    static const CrcKernel kernel = selectCrcKernel();
+    return kernel(crc, data, length);
+}
+
+uint32_t memcrcUpdatePortable(uint32_t crc, const unsigned char* data, size_t length) {
+    const uint32_t (&t0)[256] = kCrcSlices[0].entries;
+    const uint32_t (&t1)[256] = kCrcSlices[1].entries;
+    const uint32_t (&t2)[256] = kCrcSlices[2].entries;
+    const uint32_t (&t3)[256] = kCrcSlices[3].entries;
+    const uint32_t (&t4)[256] = kCrcSlices[4].entries;
+    const uint32_t (&t5)[256] = kCrcSlices[5].entries;
+    const uint32_t (&t6)[256] = kCrcSlices[6].entries;
+    const uint32_t (&t7)[256] = kCrcSlices[7].entries;
+
+    // The eight lookups of a step are independent of each other, unlike the
+    // byte at a time loop where every lookup waits for the previous one.
+    while (length >= kCrcSliceCount) {
+        uint32_t high = crc ^ (uint32_t(data[0]) << 24 | uint32_t(data[1]) << 16 |
+            uint32_t(data[2]) << 8 | data[3]);
+
+        crc = t7[high >> 24] ^ t6[(high >> 16) & 0xFF] ^ t5[(high >> 8) & 0xFF] ^ t4[high & 0xFF] ^
+            t3[data[4]] ^ t2[data[5]] ^ t1[data[6]] ^ t0[data[7]];
+
+        data += kCrcSliceCount;
+        length -= kCrcSliceCount;
+    }
+
+    for (size_t i = 0; i < length; ++i) {
+        crc = t0[data[i] ^ (crc >> 24)] ^ (crc << 8);
+    }
+
+    return crc;
+}
+
+CrcState::CrcState()
+    : crc_(kCrcSeed) {}
+
+void CrcState::init() {
+    crc_ = kCrcSeed;
+}
+
+CrcState& CrcState::update(const void* data, size_t length) {
+    crc_ = memcrcUpdate(crc_, static_cast<const unsigned char*>(data), length);
+    return *this;
+}
+
+uint32_t CrcState::finalize() const {
+    return ~crc_;
+}
+
+namespace {
+
+const size_t kMinParallelChunk = 1024 * 1024;
+
+// Multiplies two polynomials modulo the checksum polynomial, with the
+// coefficient of x^31 in the top bit.
+uint32_t multiplyModulo(uint32_t a, uint32_t b) {
+    uint32_t product = 0;
+
+    for (int bit = 31; bit >= 0; --bit) {
+        product = (product & 0x80000000) ? (product << 1) ^ kCrcPolynomial : (product << 1);
+
+        if (b & (uint32_t(1) << bit)) {
+            product ^= a;
+        }
+    }
+
+    return product;
+}
+
+}  // namespace
+
+uint32_t crcCombine(uint32_t crc_a, uint32_t crc_b, size_t length_b) {
+    // The seed and final inversion cancel out, leaving
+    // crc(a + b) = crc(a) * x^(8 * length_b) + crc(b), computed by squaring.
+    uint32_t shift = 1;           // x^0
+    uint32_t power = 1u << 8;     // x^8, one byte of zeros
+
+    for (uint64_t remaining = length_b; remaining; remaining >>= 1) {
+        if (remaining & 1) {
+            shift = multiplyModulo(shift, power);
+        }
+
+        power = multiplyModulo(power, power);
+    }
+
+    return multiplyModulo(crc_a, shift) ^ crc_b;
+}
+
+uint32_t memcrcParallel(const void* data, size_t length, size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, boost::thread::hardware_concurrency());
+    }
+
+    size_t chunk_count = std::max<size_t>(1, std::min(threads, length / kMinParallelChunk));
+    size_t chunk_length = length / chunk_count;
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    std::vector<uint32_t> checksums(chunk_count);
+
+    boost::thread_group workers;
+
+    // The calling thread takes the first chunk, the last one also covers
+    // whatever is left over by the division.
+    try {
+        for (size_t i = 1; i < chunk_count; ++i) {
+            const unsigned char* chunk = bytes + i * chunk_length;
+            size_t size = (i + 1 == chunk_count) ? length - i * chunk_length : chunk_length;
+            uint32_t* checksum = &checksums[i];
+
+            workers.create_thread([chunk, size, checksum] {
+                *checksum = ~memcrcUpdate(kCrcSeed, chunk, size);
+            });
+        }
+    } catch (...) {
+        // Workers already started still write into checksums.
+        workers.join_all();
+        throw;
+    }
+
+    checksums[0] = ~memcrcUpdate(kCrcSeed, bytes, (chunk_count == 1) ? length : chunk_length);
+
+    workers.join_all();
+
+    uint32_t crc = checksums[0];
+    for (size_t i = 1; i < chunk_count; ++i) {
+        size_t size = (i + 1 == chunk_count) ? length - i * chunk_length : chunk_length;
+        crc = crcCombine(crc, checksums[i], size);
+    }
+
+    return crc;
+}
+
 }  // namespace anh
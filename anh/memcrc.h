@@ -5,6 +5,7 @@
 #ifndef ANH_CRC_H_
 #define ANH_CRC_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 
@@ -23,7 +24,7 @@ namespace anh {
  * \param length The length of the source_string.
  * \returns A 32-bit checksum of the string.
  */
-uint32_t memcrc(char const * const source_string, uint32_t length);
+uint32_t memcrc(char const * const source_string, size_t length);
 
 
 /**
@@ -38,6 +39,169 @@ uint32_t memcrc(char const * const source_string, uint32_t length);
  */
 uint32_t memcrc(const std::string& source_string);
 
+/// The running value an incremental checksum starts from.
+const uint32_t kCrcSeed = 0xffffffff;
+
+/**
+ * Adds more bytes to a running checksum, for data that is produced in pieces.
+ * Start from kCrcSeed and invert the final value, so that
+ * ~memcrcUpdate(kCrcSeed, data, length) equals memcrc(data, length).
+ *
+ * \param crc The running value returned by the previous call, or kCrcSeed.
+ * \param data The bytes to add.
+ * \param length The number of bytes to add.
+ * \returns The updated running value.
+ */
+uint32_t memcrcUpdate(uint32_t crc, const unsigned char* data, size_t length);
+
+/**
+ * The implementations memcrcUpdate chooses between, exposed so that tests and
+ * benchmarks can run each of them. The portable version slices the table
+ * eight bytes at a time; the other folds 64 bytes at a time with carry-less
+ * multiplication and may only be called when memcrcClmulSupported() is true.
+ */
+uint32_t memcrcUpdatePortable(uint32_t crc, const unsigned char* data, size_t length);
+uint32_t memcrcUpdateClmul(uint32_t crc, const unsigned char* data, size_t length);
+
+/// \returns True if the processor supports the PCLMULQDQ instruction.
+bool memcrcClmulSupported();
+
+/*! \brief Computes the same checksum as memcrc over data that arrives in
+ * pieces, such as segmented buffers, streamed files or partial network reads.
+ *
+ * \code
+ * anh::CrcState crc;
+ * while (size_t length = file.read(chunk, sizeof(chunk))) {
+ *     crc.update(chunk, length);
+ * }
+ * uint32_t checksum = crc.finalize();
+ * \endcode
+ */
+class CrcState {
+public:
+    /// Creates a state that has seen no data.
+    CrcState();
+
+    /// Starts over, forgetting all data seen so far.
+    void init();
+
+    /**
+     * Adds the next piece of the data.
+     *
+     * \param data The bytes to add.
+     * \param length The number of bytes to add.
+     */
+    CrcState& update(const void* data, size_t length);
+
+    /// \returns The checksum of all data seen so far, equal to memcrc of it.
+    uint32_t finalize() const;
+
+private:
+    uint32_t crc_;
+};
+
+/**
+ * Combines the checksums of two pieces of data into the checksum of both,
+ * without looking at the data again. Pieces checksummed separately, for
+ * example in parallel, can be joined this way.
+ *
+ * \param crc_a The checksum of the first piece, as returned by memcrc.
+ * \param crc_b The checksum of the second piece, as returned by memcrc.
+ * \param length_b The length of the second piece in bytes.
+ * \returns The checksum of the first piece followed by the second.
+ */
+uint32_t crcCombine(uint32_t crc_a, uint32_t crc_b, size_t length_b);
+
+/**
+ * Calculates memcrc of a large buffer on several threads. The buffer is split
+ * into one chunk per thread and the checksums of the chunks are joined with
+ * crcCombine, so the result is the same as memcrc's.
+ *
+ * Chunks are never smaller than a megabyte, so small buffers use fewer
+ * threads and a buffer under two megabytes is checksummed on the calling
+ * thread alone.
+ *
+ * \param data The bytes to checksum.
+ * \param length The number of bytes to checksum.
+ * \param threads The most threads to use, including the calling one. 0 uses
+ *     one per hardware thread.
+ * \returns A 32-bit checksum of the data.
+ */
+uint32_t memcrcParallel(const void* data, size_t length, size_t threads = 0);
+
+// The tables and checksum below are constexpr so that idents of string
+// literals can be computed during compilation.
+
+/// The cksum polynomial, processed most significant bit first.
+const uint32_t kCrcPolynomial = 0x04C11DB7;
+
+/// \returns crc multiplied by x^bits modulo the polynomial.
+constexpr uint32_t crcShiftBits(uint32_t crc, unsigned bits) {
+    return bits == 0 ? crc :
+        crcShiftBits((crc & 0x80000000) ? (crc << 1) ^ kCrcPolynomial : (crc << 1), bits - 1);
+}
+
+/// \returns The checksum contribution of a byte followed by slice zero bytes.
+constexpr uint32_t crcSliceEntry(size_t slice, uint32_t byte) {
+    return crcShiftBits(byte << 24, static_cast<unsigned>(8 * (slice + 1)));
+}
+
+template<size_t... Bytes>
+struct CrcByteList {};
+
+template<size_t Count, size_t... Bytes>
+struct MakeCrcByteList : MakeCrcByteList<Count - 1, Count - 1, Bytes...> {};
+
+template<size_t... Bytes>
+struct MakeCrcByteList<0, Bytes...> {
+    typedef CrcByteList<Bytes...> type;
+};
+
+/// A lookup table holding crcSliceEntry for every byte value.
+struct CrcSlice {
+    uint32_t entries[256];
+};
+
+template<size_t Slice, size_t... Bytes>
+constexpr CrcSlice makeCrcSlice(CrcByteList<Bytes...>) {
+    return CrcSlice{{ crcSliceEntry(Slice, Bytes)... }};
+}
+
+/// The byte at a time table.
+constexpr CrcSlice kCrcTable = makeCrcSlice<0>(MakeCrcByteList<256>::type());
+
+/// The constexpr counterpart of memcrcUpdate, a byte at a time.
+constexpr uint32_t memcrcConstantUpdate(uint32_t crc, const char* data, size_t length) {
+    return length == 0 ? crc :
+        memcrcConstantUpdate(kCrcTable.entries[static_cast<unsigned char>(data[0]) ^ (crc >> 24)] ^ (crc << 8),
+            data + 1, length - 1);
+}
+
+/**
+ * Calculates the same checksum as memcrc, during compilation when the
+ * arguments are constant. Each byte is a level of recursion, so keep
+ * compile time inputs to a few hundred bytes and use memcrc at runtime.
+ *
+ * \code
+ * switch (event->event_type().ident()) {
+ *     case anh::memcrcConstant("player_logged_in"): ...
+ * }
+ * \endcode
+ *
+ * \param data The bytes to checksum.
+ * \param length The number of bytes to checksum.
+ * \returns A 32-bit checksum of the data.
+ */
+constexpr uint32_t memcrcConstant(const char* data, size_t length) {
+    return ~memcrcConstantUpdate(kCrcSeed, data, length);
+}
+
+/// Calculates memcrcConstant of a string literal, without its terminator.
+template<size_t Length>
+constexpr uint32_t memcrcConstant(const char (&literal)[Length]) {
+    return memcrcConstant(literal, Length - 1);
+}
+
 }  // namespace anh
 
 #endif  // ANH_CRC_H_
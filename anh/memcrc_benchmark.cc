@@ -0,0 +1,93 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/memcrc.h"
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+// Wrapping benchmarks in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+std::vector<unsigned char> makeData(size_t length) {
+    std::mt19937 generator(42);
+    std::vector<unsigned char> data(length);
+
+    for (size_t i = 0; i < length; ++i) {
+        data[i] = static_cast<unsigned char>(generator());
+    }
+
+    return data;
+}
+
+void BM_Memcrc(benchmark::State& state) {
+    std::vector<unsigned char> data = makeData(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        uint32_t crc = anh::memcrcUpdate(anh::kCrcSeed, data.data(), data.size());
+        benchmark::DoNotOptimize(crc);
+    }
+
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Memcrc)->Arg(16)->Arg(64)->Arg(256)->Arg(4096)->Arg(65536);
+
+void BM_MemcrcPortable(benchmark::State& state) {
+    std::vector<unsigned char> data = makeData(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        uint32_t crc = anh::memcrcUpdatePortable(anh::kCrcSeed, data.data(), data.size());
+        benchmark::DoNotOptimize(crc);
+    }
+
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_MemcrcPortable)->Arg(256)->Arg(4096)->Arg(65536);
+
+void BM_MemcrcClmul(benchmark::State& state) {
+    if (!anh::memcrcClmulSupported()) {
+        state.SkipWithError("PCLMULQDQ is not supported");
+        return;
+    }
+
+    std::vector<unsigned char> data = makeData(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state) {
+        uint32_t crc = anh::memcrcUpdateClmul(anh::kCrcSeed, data.data(), data.size());
+        benchmark::DoNotOptimize(crc);
+    }
+
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_MemcrcClmul)->Arg(256)->Arg(4096)->Arg(65536);
+
+// A snapshot sized buffer split over one to eight threads.
+void BM_MemcrcParallel(benchmark::State& state) {
+    std::vector<unsigned char> data = makeData(128 * 1024 * 1024);
+
+    for (auto _ : state) {
+        uint32_t crc = anh::memcrcParallel(data.data(), data.size(), static_cast<size_t>(state.range(0)));
+        benchmark::DoNotOptimize(crc);
+    }
+
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_MemcrcParallel)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+// Event type idents are hashed from short names.
+void BM_MemcrcEventTypeName(benchmark::State& state) {
+    std::string name("object_update_position");
+
+    for (auto _ : state) {
+        uint32_t crc = anh::memcrc(name);
+        benchmark::DoNotOptimize(crc);
+    }
+
+    state.SetBytesProcessed(state.iterations() * name.length());
+}
+BENCHMARK(BM_MemcrcEventTypeName);
+
+}  // namespace
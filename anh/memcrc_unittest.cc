@@ -4,10 +4,31 @@
 
 #include "anh/memcrc.h"
 
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
 #include <gtest/gtest.h>
 
+#include "anh/hash_string.h"
+
 // Wrapping tests in an anonymous namespace prevents potential name conflicts.
 namespace {
+
+// The checksum one bit at a time, straight from the definition, to compare
+// the table driven versions against.
+uint32_t referenceCrcUpdate(uint32_t crc, const unsigned char* data, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        crc ^= uint32_t(data[i]) << 24;
+
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+        }
+    }
+
+    return crc;
+}
     
 /// This test shows how to find the 32bit checksum of a c-style string.
 TEST(CrcTests, CanCrcCstyleStrings) {
@@ -23,4 +44,200 @@ TEST(CrcTests, CanCrcStdStrings) {
     EXPECT_EQ(uint32_t(0x19522193), anh::memcrc(std::string("aThirdTest")));
 }
 
+/// This test shows how to checksum data that arrives in pieces.
+TEST(CrcTests, IncrementalUpdatesMatchSinglePass) {
+    std::string data("a string long enough to be split in several places");
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data.data());
+
+    for (size_t split = 0; split <= data.length(); ++split) {
+        uint32_t crc = anh::memcrcUpdate(anh::kCrcSeed, bytes, split);
+        crc = anh::memcrcUpdate(crc, bytes + split, data.length() - split);
+
+        EXPECT_EQ(anh::memcrc(data), ~crc);
+    }
+}
+
+/// Bytes with the high bit set are checksummed as unsigned values.
+TEST(CrcTests, HighBytesAreChecksummedAsUnsigned) {
+    const unsigned char bytes[] = { 0x80, 0xFF, 0x7F, 0x00 };
+
+    EXPECT_EQ(anh::memcrc(reinterpret_cast<const char*>(bytes), 4),
+        ~anh::memcrcUpdate(anh::kCrcSeed, bytes, 4));
+    EXPECT_NE(anh::memcrc(reinterpret_cast<const char*>(bytes), 4),
+        anh::memcrc(reinterpret_cast<const char*>(bytes), 3));
+}
+
+/// Every length and alignment around the eight byte steps matches the
+/// bit by bit definition.
+TEST(CrcTests, MatchesReferenceOverRandomInputs) {
+    std::mt19937 generator(1234);
+    std::vector<unsigned char> data(4096 + 8);
+
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<unsigned char>(generator());
+    }
+
+    for (size_t length = 0; length <= 80; ++length) {
+        for (size_t offset = 0; offset < 8; ++offset) {
+            EXPECT_EQ(~referenceCrcUpdate(anh::kCrcSeed, &data[offset], length),
+                anh::memcrc(reinterpret_cast<const char*>(&data[offset]), static_cast<uint32_t>(length)))
+                << "length " << length << " offset " << offset;
+        }
+    }
+
+    for (int i = 0; i < 200; ++i) {
+        size_t offset = generator() % 8;
+        size_t length = generator() % 4096;
+        uint32_t seed = generator();
+
+        EXPECT_EQ(referenceCrcUpdate(seed, &data[offset], length),
+            anh::memcrcUpdate(seed, &data[offset], length));
+        EXPECT_EQ(referenceCrcUpdate(seed, &data[offset], length),
+            anh::memcrcUpdatePortable(seed, &data[offset], length));
+    }
+}
+
+/// The carry-less multiply version matches the portable one wherever the
+/// processor can run it.
+TEST(CrcTests, ClmulMatchesPortable) {
+    if (!anh::memcrcClmulSupported()) {
+        std::cout << "PCLMULQDQ is not supported, skipping" << std::endl;
+        return;
+    }
+
+    std::mt19937 generator(5678);
+    std::vector<unsigned char> data(65536 + 16);
+
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<unsigned char>(generator());
+    }
+
+    // Every way the data can split between the 64 and 16 byte loops and the tail.
+    for (size_t length = 0; length <= 320; ++length) {
+        size_t offset = length % 16;
+
+        EXPECT_EQ(anh::memcrcUpdatePortable(anh::kCrcSeed, &data[offset], length),
+            anh::memcrcUpdateClmul(anh::kCrcSeed, &data[offset], length))
+            << "length " << length << " offset " << offset;
+    }
+
+    for (int i = 0; i < 100; ++i) {
+        size_t offset = generator() % 16;
+        size_t length = generator() % 65536;
+        uint32_t seed = generator();
+
+        EXPECT_EQ(anh::memcrcUpdatePortable(seed, &data[offset], length),
+            anh::memcrcUpdateClmul(seed, &data[offset], length));
+    }
+}
+
+/// Idents generated before the checksum was table sliced stay the same.
+TEST(CrcTests, HashStringIdentsAreUnchanged) {
+    EXPECT_EQ(uint32_t(0x107D0089), anh::HashString("test_hash_string").ident());
+    EXPECT_EQ(uint32_t(0xC3CEA198), anh::HashString("mock_event").ident());
+
+    std::string name("a_rather_long_event_type_name_spanning_several_steps");
+    EXPECT_EQ(~referenceCrcUpdate(anh::kCrcSeed, reinterpret_cast<const unsigned char*>(name.data()), name.length()),
+        anh::HashString(name.c_str()).ident());
+}
+
+/// This test shows how to checksum data that arrives in pieces with a CrcState.
+TEST(CrcTests, StreamingMatchesSinglePass) {
+    std::string data(1000, '\0');
+    for (size_t i = 0; i < data.length(); ++i) {
+        data[i] = static_cast<char>(i * 7);
+    }
+
+    for (size_t piece = 1; piece <= 130; piece += 3) {
+        anh::CrcState crc;
+
+        for (size_t offset = 0; offset < data.length(); offset += piece) {
+            crc.update(data.data() + offset, std::min(piece, data.length() - offset));
+        }
+
+        EXPECT_EQ(anh::memcrc(data), crc.finalize()) << "piece " << piece;
+    }
+}
+
+TEST(CrcTests, StateCanStartOver) {
+    anh::CrcState crc;
+    crc.update("unrelated", 9);
+    crc.init();
+
+    EXPECT_EQ(anh::memcrc("test"), crc.update("te", 2).update("st", 2).finalize());
+    EXPECT_EQ(anh::memcrc("", 0), anh::CrcState().finalize());
+}
+
+/// Checksums of two pieces combine into the checksum of both.
+TEST(CrcTests, CombineMatchesSinglePass) {
+    std::mt19937 generator(91);
+    std::vector<char> data(2048);
+
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>(generator());
+    }
+
+    for (size_t split = 0; split <= data.size(); split += (split < 80) ? 1 : 97) {
+        uint32_t crc_a = anh::memcrc(&data[0], split);
+        uint32_t crc_b = anh::memcrc(&data[0] + split, data.size() - split);
+
+        EXPECT_EQ(anh::memcrc(&data[0], data.size()), anh::crcCombine(crc_a, crc_b, data.size() - split))
+            << "split " << split;
+    }
+}
+
+/// Combining is associative, which also holds for pieces beyond 4GB.
+TEST(CrcTests, CombineIsAssociativeForLargeLengths) {
+    uint32_t crc_a = anh::memcrc("first");
+    uint32_t crc_b = 0x12345678;
+    uint32_t crc_c = 0x9ABCDEF0;
+
+    // Well beyond 4GB wherever size_t can hold it.
+    size_t length_b = (size_t(1) << (sizeof(size_t) * 8 - 2)) + 5;
+    size_t length_c = (size_t(1) << (sizeof(size_t) * 8 - 2)) - 3;
+
+    EXPECT_EQ(anh::crcCombine(anh::crcCombine(crc_a, crc_b, length_b), crc_c, length_c),
+        anh::crcCombine(crc_a, anh::crcCombine(crc_b, crc_c, length_c), length_b + length_c));
+}
+
+/// Splitting the work over threads gives the same checksum as one pass.
+TEST(CrcTests, ParallelMatchesSerial) {
+    std::mt19937 generator(4321);
+    std::vector<unsigned char> data(5 * 1024 * 1024 + 13);
+
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<unsigned char>(generator());
+    }
+
+    uint32_t serial = anh::memcrc(reinterpret_cast<const char*>(&data[0]), data.size());
+
+    for (size_t threads = 0; threads <= 8; ++threads) {
+        EXPECT_EQ(serial, anh::memcrcParallel(&data[0], data.size(), threads)) << "threads " << threads;
+    }
+
+    // Small buffers stay on the calling thread.
+    EXPECT_EQ(anh::memcrc("test"), anh::memcrcParallel("test", 4, 4));
+    EXPECT_EQ(anh::memcrc("", 0), anh::memcrcParallel(nullptr, 0, 4));
+}
+
+static_assert(anh::memcrcConstant("test") == 0x338BCFAC, "Compile time checksum differs");
+static_assert(anh::kCrcTable.entries[1] == anh::kCrcPolynomial, "Compile time table differs");
+
+/// The constexpr checksum gives the same values as the runtime one, also when
+/// it is called at runtime.
+TEST(CrcTests, ConstantMatchesRuntime) {
+    std::mt19937 generator(2468);
+    std::vector<char> data(300);
+
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>(generator());
+    }
+
+    for (size_t length = 0; length <= data.size(); ++length) {
+        EXPECT_EQ(anh::memcrc(&data[0], length), anh::memcrcConstant(&data[0], length));
+    }
+
+    EXPECT_EQ(anh::memcrc("anothertest"), anh::memcrcConstant("anothertest"));
+}
+
 }  // namespace
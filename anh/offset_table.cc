@@ -0,0 +1,144 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/offset_table.h"
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+namespace {
+
+const size_t kMaxOffset = 0xFFFF;
+
+size_t headerSize(size_t field_count) {
+    return sizeof(uint16_t) * (field_count + 1);
+}
+
+uint16_t loadLittleEndian16(const unsigned char* data) {
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+}  // namespace
+
+OffsetTableWriter::OffsetTableWriter(ByteBuffer& buffer, size_t field_count)
+    : buffer_(buffer)
+    , header_position_(buffer.writePosition())
+    , field_count_(field_count)
+    , fields_written_(0) {
+    if (field_count > kMaxOffset) {
+        throw std::runtime_error("Too many fields for an offset table");
+    }
+
+    LittleEndianWriter writer(buffer_);
+    writer.write<uint16_t>(static_cast<uint16_t>(field_count));
+
+    for (size_t i = 0; i < field_count; ++i) {
+        writer.write<uint16_t>(0);
+    }
+}
+
+OffsetTableWriter& OffsetTableWriter::write(const unsigned char* data, size_t size) {
+    beginField();
+    buffer_.write(data, size);
+    endField();
+    return *this;
+}
+
+void OffsetTableWriter::finish() {
+    if (fields_written_ != field_count_) {
+        throw std::logic_error("Offset table record is missing fields");
+    }
+}
+
+void OffsetTableWriter::beginField() {
+    if (fields_written_ == field_count_) {
+        throw std::logic_error("Offset table record already holds all of its fields");
+    }
+}
+
+void OffsetTableWriter::endField() {
+    size_t fields_position = header_position_ + headerSize(field_count_);
+    size_t end = buffer_.writePosition() - fields_position;
+
+    if (end > kMaxOffset) {
+        throw std::runtime_error("Offset table record exceeds 65535 bytes");
+    }
+
+    size_t offset_position = header_position_ + sizeof(uint16_t) * (fields_written_ + 1);
+    LittleEndianWriter(buffer_).writeAt<uint16_t>(offset_position, static_cast<uint16_t>(end));
+
+    ++fields_written_;
+}
+
+OffsetTableView::OffsetTableView(ByteBuffer& in) {
+    size_t available = in.size() - in.readPosition();
+
+    field_count_ = LittleEndianReader(in).read<uint16_t>();
+
+    if (available < headerSize(field_count_)) {
+        throw std::out_of_range("Read past end of buffer");
+    }
+
+    offsets_ = in.data() + in.readPosition();
+    fields_ = offsets_ + sizeof(uint16_t) * field_count_;
+
+    // Checking the offsets once up front lets every lookup trust them.
+    size_t end = 0;
+    for (size_t i = 0; i < field_count_; ++i) {
+        size_t next = loadLittleEndian16(offsets_ + sizeof(uint16_t) * i);
+
+        if (next < end) {
+            throw std::runtime_error("Offset table offsets are not in order");
+        }
+
+        end = next;
+    }
+
+    if (available - headerSize(field_count_) < end) {
+        throw std::out_of_range("Read past end of buffer");
+    }
+
+    in.readPosition(in.readPosition() + sizeof(uint16_t) * field_count_ + end);
+}
+
+size_t OffsetTableView::field_count() const {
+    return field_count_;
+}
+
+const unsigned char* OffsetTableView::fieldData(size_t index) const {
+    return fields_ + fieldOffset(index);
+}
+
+size_t OffsetTableView::fieldSize(size_t index) const {
+    size_t start = fieldOffset(index);
+    return loadLittleEndian16(offsets_ + sizeof(uint16_t) * index) - start;
+}
+
+StringView OffsetTableView::getString(size_t index) const {
+    size_t size = fieldSize(index);
+
+    uint16_t length;
+    if (size < sizeof(length)) {
+        throw std::runtime_error("Field does not hold a string");
+    }
+
+    std::memcpy(&length, fieldData(index), sizeof(length));
+
+    if (size != sizeof(length) + length) {
+        throw std::runtime_error("Field does not hold a string");
+    }
+
+    return StringView(reinterpret_cast<const char*>(fieldData(index)) + sizeof(length), length);
+}
+
+size_t OffsetTableView::fieldOffset(size_t index) const {
+    if (index >= field_count_) {
+        throw std::out_of_range("Offset table record has no such field");
+    }
+
+    return (index == 0) ? 0 : loadLittleEndian16(offsets_ + sizeof(uint16_t) * (index - 1));
+}
+
+}  // namespace anh
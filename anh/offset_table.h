@@ -0,0 +1,170 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#ifndef ANH_OFFSET_TABLE_H_
+#define ANH_OFFSET_TABLE_H_
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#include "anh/byte_buffer.h"
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+/*! \brief Writes a record whose header lists where each of its fields ends,
+ * so a receiver can read any single field without decoding the others.
+ *
+ * The header is a little endian uint16 field count followed by the little
+ * endian uint16 end offset of every field, counted from the end of the
+ * header. Each call to write adds one field, written with
+ * ByteBuffer::write<T> as usual, and backpatches its offset in place. A
+ * record can hold at most 65535 bytes of fields.
+ *
+ * \code
+ * anh::OffsetTableWriter record(buffer, 3);
+ * record.write<uint64_t>(subject).write<uint32_t>(flags).write<std::string>(name);
+ * record.finish();
+ * \endcode
+ *
+ * \see OffsetTableView
+ */
+class OffsetTableWriter {
+public:
+    /**
+     * Reserves the header of a record at the write position of a buffer.
+     *
+     * \param buffer The buffer to write the record to.
+     * \param field_count The number of fields the record will hold.
+     * \throws std::runtime_error If field_count is more than 65535.
+     */
+    OffsetTableWriter(ByteBuffer& buffer, size_t field_count);
+
+    /**
+     * Writes one field with ByteBuffer::write<T>.
+     *
+     * \throws std::logic_error If the record already holds all of its fields.
+     * \throws std::runtime_error If the fields grow past 65535 bytes.
+     */
+    template<typename T> OffsetTableWriter& write(const T& data);
+
+    /// Writes one field of raw bytes.
+    OffsetTableWriter& write(const unsigned char* data, size_t size);
+
+    /**
+     * Checks the record is complete. Nothing may be written to it afterwards.
+     *
+     * \throws std::logic_error If fewer fields were written than the record
+     *     was created with.
+     */
+    void finish();
+
+private:
+    /// Disable copying, both copies would write to the same record.
+    OffsetTableWriter(const OffsetTableWriter&);
+    OffsetTableWriter& operator=(const OffsetTableWriter&);
+
+    void beginField();
+    void endField();
+
+    ByteBuffer& buffer_;
+    size_t header_position_;
+    size_t field_count_;
+    size_t fields_written_;
+};
+
+/*! \brief Reads individual fields of a record written by OffsetTableWriter
+ * straight out of the received buffer.
+ *
+ * Constructing a view only checks the header, fields are read on demand.
+ * Listeners that look at one or two fields of an event skip decoding the
+ * rest of it.
+ *
+ * \code
+ * anh::OffsetTableView record(buffer);
+ * if (record.get<uint64_t>(0) == player_id) {
+ *     std::string name = record.getString(2).str();
+ * }
+ * \endcode
+ *
+ * The view points into the buffer and is only valid until the buffer is
+ * next modified.
+ */
+class OffsetTableView {
+public:
+    /**
+     * Reads the header of a record at the read position of a buffer and
+     * moves the read position past the whole record.
+     *
+     * \param in The buffer holding the record.
+     * \throws std::out_of_range If the record runs past the end of the buffer.
+     * \throws std::runtime_error If the offsets in the header are inconsistent.
+     */
+    explicit OffsetTableView(ByteBuffer& in);
+
+    /// \returns The number of fields in the record.
+    size_t field_count() const;
+
+    /**
+     * \param index The field to look up.
+     * \returns The first byte of the field.
+     * \throws std::out_of_range If the record has no such field.
+     */
+    const unsigned char* fieldData(size_t index) const;
+
+    /// \returns The size in bytes of a field.
+    size_t fieldSize(size_t index) const;
+
+    /**
+     * Reads an arithmetic or enum field written with write<T>.
+     *
+     * \throws std::out_of_range If the record has no such field.
+     * \throws std::runtime_error If the field is not sizeof(T) bytes.
+     */
+    template<typename T> T get(size_t index) const;
+
+    /**
+     * Reads a string field written with write<std::string> without copying it.
+     *
+     * \throws std::out_of_range If the record has no such field.
+     * \throws std::runtime_error If the field does not hold a string.
+     */
+    StringView getString(size_t index) const;
+
+private:
+    size_t fieldOffset(size_t index) const;
+
+    const unsigned char* offsets_;
+    const unsigned char* fields_;
+    size_t field_count_;
+};
+
+template<typename T>
+OffsetTableWriter& OffsetTableWriter::write(const T& data) {
+    beginField();
+    buffer_.write<T>(data);
+    endField();
+    return *this;
+}
+
+template<typename T>
+T OffsetTableView::get(size_t index) const {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+        "Only arithmetic and enum fields can be read with get<T>");
+
+    if (fieldSize(index) != sizeof(T)) {
+        throw std::runtime_error("Field size does not match the requested type");
+    }
+
+    T data;
+    std::memcpy(&data, fieldData(index), sizeof(T));
+    return data;
+}
+
+}  // namespace anh
+
+#endif  // ANH_OFFSET_TABLE_H_
@@ -0,0 +1,133 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/offset_table.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+using anh::ByteBuffer;
+using anh::OffsetTableView;
+using anh::OffsetTableWriter;
+
+// Wrapping tests in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+void writeRecord(ByteBuffer& buffer) {
+    OffsetTableWriter record(buffer, 4);
+    record.write<uint64_t>(0xDEADBEEFCAFEULL)
+        .write<uint32_t>(7)
+        .write<std::string>("Han Solo")
+        .write<float>(1.5f);
+    record.finish();
+}
+
+TEST(OffsetTableTests, HeaderHoldsFieldEndOffsets)
+{
+    ByteBuffer buffer;
+    writeRecord(buffer);
+
+    anh::LittleEndianReader reader(buffer);
+    EXPECT_EQ(4u, reader.read<uint16_t>());
+    EXPECT_EQ(8u, reader.read<uint16_t>());
+    EXPECT_EQ(12u, reader.read<uint16_t>());
+    EXPECT_EQ(22u, reader.read<uint16_t>());
+    EXPECT_EQ(26u, reader.read<uint16_t>());
+
+    EXPECT_EQ(0xDEADBEEFCAFEULL, buffer.read<uint64_t>());
+}
+
+TEST(OffsetTableTests, CanReadFieldsInAnyOrder)
+{
+    ByteBuffer buffer;
+    writeRecord(buffer);
+
+    OffsetTableView record(buffer);
+
+    ASSERT_EQ(4u, record.field_count());
+    EXPECT_EQ(1.5f, record.get<float>(3));
+    EXPECT_EQ("Han Solo", record.getString(2).str());
+    EXPECT_EQ(0xDEADBEEFCAFEULL, record.get<uint64_t>(0));
+    EXPECT_EQ(7u, record.get<uint32_t>(1));
+    EXPECT_EQ(10u, record.fieldSize(2));
+}
+
+TEST(OffsetTableTests, FieldsAreReadFromTheBuffer)
+{
+    ByteBuffer buffer;
+    writeRecord(buffer);
+
+    OffsetTableView record(buffer);
+    EXPECT_EQ(buffer.data() + 10, record.fieldData(0));
+}
+
+TEST(OffsetTableTests, ViewSkipsPastTheRecord)
+{
+    ByteBuffer buffer;
+    writeRecord(buffer);
+    buffer.write<uint32_t>(0x12345678);
+
+    OffsetTableView record(buffer);
+    EXPECT_EQ(0x12345678u, buffer.read<uint32_t>());
+}
+
+TEST(OffsetTableTests, CanWriteAfterExistingData)
+{
+    ByteBuffer buffer;
+    buffer.write<uint32_t>(0xC3CEA198);
+    writeRecord(buffer);
+
+    EXPECT_EQ(0xC3CEA198, buffer.read<uint32_t>());
+
+    OffsetTableView record(buffer);
+    EXPECT_EQ(7u, record.get<uint32_t>(1));
+}
+
+TEST(OffsetTableTests, WrongFieldCountThrowsException)
+{
+    ByteBuffer buffer;
+
+    OffsetTableWriter record(buffer, 1);
+    record.write<uint8_t>(1);
+    EXPECT_THROW(record.write<uint8_t>(2), std::logic_error);
+
+    OffsetTableWriter incomplete(buffer, 2);
+    incomplete.write<uint8_t>(1);
+    EXPECT_THROW(incomplete.finish(), std::logic_error);
+}
+
+TEST(OffsetTableTests, MismatchedFieldTypeThrowsException)
+{
+    ByteBuffer buffer;
+    writeRecord(buffer);
+
+    OffsetTableView record(buffer);
+    EXPECT_THROW(record.get<uint32_t>(0), std::runtime_error);
+    EXPECT_THROW(record.getString(1), std::runtime_error);
+    EXPECT_THROW(record.get<uint32_t>(4), std::out_of_range);
+}
+
+TEST(OffsetTableTests, TruncatedRecordThrowsException)
+{
+    ByteBuffer buffer;
+    writeRecord(buffer);
+
+    ByteBuffer truncated(buffer.data(), buffer.size() - 1);
+    EXPECT_THROW(OffsetTableView record(truncated), std::out_of_range);
+
+    ByteBuffer header_only(buffer.data(), 4);
+    EXPECT_THROW(OffsetTableView record(header_only), std::out_of_range);
+}
+
+TEST(OffsetTableTests, OffsetsOutOfOrderThrowException)
+{
+    ByteBuffer buffer;
+    anh::LittleEndianWriter(buffer).write<uint16_t>(2).write<uint16_t>(4).write<uint16_t>(2);
+    buffer.write<uint32_t>(0);
+
+    EXPECT_THROW(OffsetTableView record(buffer), std::runtime_error);
+}
+
+}  // namespace
@@ -0,0 +1,81 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/shared_buffer.h"
+
+#include <stdexcept>
+#include <utility>
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+SharedBuffer::SharedBuffer()
+    : offset_(0)
+    , length_(0) {}
+
+SharedBuffer::SharedBuffer(const std::shared_ptr<Storage>& storage, size_t offset, size_t length)
+    : storage_(storage)
+    , offset_(offset)
+    , length_(length) {}
+
+SharedBuffer SharedBuffer::freeze(ByteBuffer& buffer) {
+    size_t length = buffer.size();
+
+    // Moving the storage steals its heap allocation, only the bytes of an
+    // inline buffer are copied.
+    std::shared_ptr<Storage> storage = std::make_shared<Storage>(std::move(buffer.raw()));
+    buffer.clear();
+
+    return SharedBuffer(storage, 0, length);
+}
+
+SharedBuffer SharedBuffer::slice(size_t offset, size_t length) const {
+    if (offset > length_ || length_ - offset < length) {
+        throw std::out_of_range("Slice past end of buffer");
+    }
+
+    return SharedBuffer(storage_, offset_ + offset, length);
+}
+
+void SharedBuffer::thaw(ByteBuffer& out) {
+    out.clear();
+
+    if (storage_ && storage_.use_count() == 1 && offset_ == 0 && length_ == storage_->size()) {
+        out.raw() = std::move(*storage_);
+        out.writePosition(out.size());
+
+        storage_.reset();
+        length_ = 0;
+        return;
+    }
+
+    out.write(data(), length_);
+}
+
+const unsigned char* SharedBuffer::data() const {
+    return storage_ ? storage_->data() + offset_ : nullptr;
+}
+
+size_t SharedBuffer::size() const {
+    return length_;
+}
+
+bool SharedBuffer::empty() const {
+    return length_ == 0;
+}
+
+const unsigned char* SharedBuffer::begin() const {
+    return data();
+}
+
+const unsigned char* SharedBuffer::end() const {
+    return data() + length_;
+}
+
+long SharedBuffer::use_count() const {
+    return storage_.use_count();
+}
+
+}  // namespace anh
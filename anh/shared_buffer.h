@@ -0,0 +1,90 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#ifndef ANH_SHARED_BUFFER_H_
+#define ANH_SHARED_BUFFER_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "anh/byte_buffer.h"
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+/*! \brief An immutable, reference counted block of bytes.
+ *
+ * Serialize once into a ByteBuffer, freeze it, and hand copies of the
+ * SharedBuffer to every recipient: copies and slices only bump a reference
+ * count and all of them point at the same bytes. The count is atomic so
+ * copies can be passed between threads.
+ *
+ * \code
+ * anh::ByteBuffer buffer;
+ * update.serialize(buffer);
+ *
+ * anh::SharedBuffer packet = anh::SharedBuffer::freeze(buffer);
+ * for (auto& session : sessions) {
+ *     session->send(packet);
+ * }
+ * \endcode
+ */
+class SharedBuffer {
+public:
+    /// Creates an empty buffer.
+    SharedBuffer();
+
+    /**
+     * Takes over the contents of a ByteBuffer without copying them. Buffers
+     * small enough to be stored inline copy those few bytes instead.
+     *
+     * \param buffer The buffer to freeze, left empty.
+     * \returns A shared buffer holding the bytes buffer held.
+     */
+    static SharedBuffer freeze(ByteBuffer& buffer);
+
+    /**
+     * Creates a buffer that shares a range of this one's bytes.
+     *
+     * \param offset The start of the range.
+     * \param length The length of the range in bytes.
+     * \throws std::out_of_range If the range runs past the end of this buffer.
+     */
+    SharedBuffer slice(size_t offset, size_t length) const;
+
+    /**
+     * Moves the bytes into a ByteBuffer for modification. They are only copied
+     * when other SharedBuffers still use them or this buffer is a slice;
+     * otherwise the storage is handed over and this buffer is left empty.
+     *
+     * \param out The buffer to replace with the contents of this one.
+     */
+    void thaw(ByteBuffer& out);
+
+    const unsigned char* data() const;
+    size_t size() const;
+    bool empty() const;
+
+    const unsigned char* begin() const;
+    const unsigned char* end() const;
+
+    /// \returns The number of SharedBuffers using the same storage.
+    long use_count() const;
+
+private:
+    typedef ByteBuffer::Storage Storage;
+
+    SharedBuffer(const std::shared_ptr<Storage>& storage, size_t offset, size_t length);
+
+    // Never modified while shared, it is only non-const so that a sole
+    // owner can hand the storage back in thaw.
+    std::shared_ptr<Storage> storage_;
+    size_t offset_;
+    size_t length_;
+};
+
+}  // namespace anh
+
+#endif  // ANH_SHARED_BUFFER_H_
@@ -0,0 +1,168 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/shared_buffer.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using anh::ByteBuffer;
+using anh::SharedBuffer;
+
+// Wrapping tests in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+// Fills a buffer too large to be stored inline.
+void fillLargeBuffer(ByteBuffer& buffer) {
+    for (uint32_t i = 0; i < 256; ++i) {
+        buffer.write<uint32_t>(i);
+    }
+}
+
+TEST(SharedBufferTests, DefaultBufferIsEmpty)
+{
+    SharedBuffer shared;
+
+    EXPECT_TRUE(shared.empty());
+    EXPECT_EQ(0u, shared.size());
+    EXPECT_EQ(0, shared.use_count());
+}
+
+TEST(SharedBufferTests, FreezingTakesOverStorageWithoutCopying)
+{
+    ByteBuffer buffer;
+    fillLargeBuffer(buffer);
+
+    const unsigned char* bytes = buffer.data();
+    size_t size = buffer.size();
+
+    SharedBuffer shared = SharedBuffer::freeze(buffer);
+
+    EXPECT_EQ(bytes, shared.data());
+    EXPECT_EQ(size, shared.size());
+    EXPECT_EQ(0u, buffer.size());
+    EXPECT_EQ(0u, buffer.writePosition());
+}
+
+TEST(SharedBufferTests, FreezingSmallBufferCopiesItsBytes)
+{
+    ByteBuffer buffer;
+    buffer.write<uint32_t>(0xDEADBEEF);
+
+    SharedBuffer shared = SharedBuffer::freeze(buffer);
+
+    ASSERT_EQ(sizeof(uint32_t), shared.size());
+    EXPECT_TRUE(std::equal(shared.begin(), shared.end(), ByteBuffer().write<uint32_t>(0xDEADBEEF).data()));
+    EXPECT_EQ(0u, buffer.size());
+}
+
+TEST(SharedBufferTests, CopiesShareTheSameBytes)
+{
+    ByteBuffer buffer;
+    fillLargeBuffer(buffer);
+
+    SharedBuffer shared = SharedBuffer::freeze(buffer);
+
+    std::vector<SharedBuffer> recipients(1000, shared);
+
+    EXPECT_EQ(1001, shared.use_count());
+    for (size_t i = 0; i < recipients.size(); ++i) {
+        EXPECT_EQ(shared.data(), recipients[i].data());
+        EXPECT_EQ(shared.size(), recipients[i].size());
+    }
+
+    recipients.clear();
+    EXPECT_EQ(1, shared.use_count());
+}
+
+TEST(SharedBufferTests, SlicesShareStorage)
+{
+    ByteBuffer buffer;
+    fillLargeBuffer(buffer);
+
+    SharedBuffer shared = SharedBuffer::freeze(buffer);
+    SharedBuffer slice = shared.slice(8, 16);
+
+    EXPECT_EQ(shared.data() + 8, slice.data());
+    EXPECT_EQ(16u, slice.size());
+    EXPECT_EQ(2, shared.use_count());
+
+    SharedBuffer nested = slice.slice(4, 4);
+    EXPECT_EQ(shared.data() + 12, nested.data());
+    EXPECT_EQ(4u, nested.size());
+}
+
+TEST(SharedBufferTests, SlicingPastEndThrowsException)
+{
+    ByteBuffer buffer;
+    fillLargeBuffer(buffer);
+
+    SharedBuffer shared = SharedBuffer::freeze(buffer);
+
+    EXPECT_NO_THROW(shared.slice(shared.size(), 0));
+    EXPECT_THROW(shared.slice(shared.size() + 1, 0), std::out_of_range);
+    EXPECT_THROW(shared.slice(1, shared.size()), std::out_of_range);
+    EXPECT_THROW(shared.slice(4, size_t(-1)), std::out_of_range);
+}
+
+TEST(SharedBufferTests, ThawingSoleOwnerHandsStorageBack)
+{
+    ByteBuffer buffer;
+    fillLargeBuffer(buffer);
+
+    SharedBuffer shared = SharedBuffer::freeze(buffer);
+    const unsigned char* bytes = shared.data();
+    size_t size = shared.size();
+
+    ByteBuffer thawed;
+    shared.thaw(thawed);
+
+    EXPECT_EQ(bytes, thawed.data());
+    EXPECT_EQ(size, thawed.size());
+    EXPECT_EQ(size, thawed.writePosition());
+    EXPECT_TRUE(shared.empty());
+
+    thawed.write<uint32_t>(256);
+    EXPECT_EQ(size + sizeof(uint32_t), thawed.size());
+}
+
+TEST(SharedBufferTests, ThawingSharedBufferCopies)
+{
+    ByteBuffer buffer;
+    fillLargeBuffer(buffer);
+
+    SharedBuffer shared = SharedBuffer::freeze(buffer);
+    SharedBuffer other = shared;
+
+    ByteBuffer thawed;
+    shared.thaw(thawed);
+
+    EXPECT_NE(other.data(), thawed.data());
+    ASSERT_EQ(other.size(), thawed.size());
+    EXPECT_TRUE(std::equal(other.begin(), other.end(), thawed.data()));
+
+    // Modifying the copy leaves the shared bytes alone.
+    thawed.write(0, reinterpret_cast<const unsigned char*>("\xFF\xFF\xFF\xFF"), 4);
+    EXPECT_EQ(0, other.data()[0]);
+    EXPECT_EQ(2, other.use_count());
+}
+
+TEST(SharedBufferTests, ThawingSliceCopiesOnlyTheSlice)
+{
+    ByteBuffer buffer;
+    fillLargeBuffer(buffer);
+
+    SharedBuffer slice = SharedBuffer::freeze(buffer).slice(4, 4);
+    EXPECT_EQ(1, slice.use_count());
+
+    ByteBuffer thawed;
+    slice.thaw(thawed);
+
+    ASSERT_EQ(4u, thawed.size());
+    EXPECT_EQ(1u, thawed.read<uint32_t>());
+}
+
+}  // namespace
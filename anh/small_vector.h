@@ -0,0 +1,291 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#ifndef ANH_SMALL_VECTOR_H_
+#define ANH_SMALL_VECTOR_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+/*! \brief A vector of trivially copyable values that keeps its first few
+ * elements inside the object and only allocates once it outgrows them.
+ *
+ * The interface is the subset of std::vector used for raw byte storage.
+ * Iterators are plain pointers and, as with std::vector, are invalidated by
+ * anything that grows the vector.
+ *
+ * \code
+ * anh::SmallVector<unsigned char, 64> bytes;
+ * bytes.resize(32);  // No allocation, the bytes live inside the object.
+ * bytes.resize(128); // Spills to the heap.
+ * \endcode
+ */
+template<typename T, size_t InlineCapacity>
+class SmallVector {
+    static_assert(std::is_trivially_copyable<T>::value, "SmallVector only holds trivially copyable values");
+    static_assert(InlineCapacity > 0, "SmallVector needs room for at least one inline element");
+
+public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    static const size_t inline_capacity = InlineCapacity;
+
+    SmallVector()
+        : data_(inlineData())
+        , size_(0)
+        , capacity_(InlineCapacity) {}
+
+    /// Creates a vector of value initialized elements.
+    explicit SmallVector(size_t size)
+        : data_(inlineData())
+        , size_(0)
+        , capacity_(InlineCapacity) {
+        resize(size);
+    }
+
+    SmallVector(const T* first, const T* last)
+        : data_(inlineData())
+        , size_(0)
+        , capacity_(InlineCapacity) {
+        reserve(last - first);
+        insert(end(), first, last);
+    }
+
+    SmallVector(const SmallVector& other)
+        : data_(inlineData())
+        , size_(0)
+        , capacity_(InlineCapacity) {
+        reserve(other.size_);
+        insert(end(), other.begin(), other.end());
+    }
+
+    SmallVector(SmallVector&& other)
+        : data_(inlineData())
+        , size_(0)
+        , capacity_(InlineCapacity) {
+        steal(other);
+    }
+
+    ~SmallVector() {
+        release();
+    }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            clear();
+            reserve(other.size_);
+            insert(end(), other.begin(), other.end());
+        }
+
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) {
+        if (this != &other) {
+            release();
+            steal(other);
+        }
+
+        return *this;
+    }
+
+    /// Heap storage is exchanged without copying, inline elements are copied.
+    void swap(SmallVector& other) { // NOLINT
+        if (!is_inline() && !other.is_inline()) {
+            std::swap(data_, other.data_);
+            std::swap(size_, other.size_);
+            std::swap(capacity_, other.capacity_);
+            return;
+        }
+
+        SmallVector temp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(temp);
+    }
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+
+    /// \returns True while the elements are stored inside the object.
+    bool is_inline() const { return data_ == inlineData(); }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+
+    iterator begin() { return data_; }
+    const_iterator begin() const { return data_; }
+    iterator end() { return data_ + size_; }
+    const_iterator end() const { return data_ + size_; }
+
+    T& operator[](size_t index) { return data_[index]; }
+    const T& operator[](size_t index) const { return data_[index]; }
+
+    void reserve(size_t capacity) {
+        if (capacity > capacity_) {
+            reallocate(capacity);
+        }
+    }
+
+    void resize(size_t size) {
+        resize(size, T());
+    }
+
+    void resize(size_t size, const T& value) {
+        if (size > size_) {
+            T copy = value;
+            grow(size);
+            std::fill(data_ + size_, data_ + size, copy);
+        }
+
+        size_ = size;
+    }
+
+    /// Changes the size without initializing any new elements, for callers
+    /// that have already written them into the spare capacity.
+    void resize_uninitialized(size_t size) {
+        grow(size);
+        size_ = size;
+    }
+
+    /// Removes every element but keeps the current storage.
+    void clear() {
+        size_ = 0;
+    }
+
+    void push_back(const T& value) {
+        T copy = value;
+        grow(size_ + 1);
+        data_[size_++] = copy;
+    }
+
+    iterator insert(iterator position, const T* first, const T* last) {
+        size_t offset = position - data_;
+        size_t count = last - first;
+
+        if (count == 0) {
+            return data_ + offset;
+        }
+
+        if (capacity_ - size_ < count || overlaps(first, last)) {
+            // Assemble the result in new storage, which also keeps the source
+            // intact when it points into this vector.
+            size_t capacity = std::max(size_ + count, capacity_ * 2);
+            T* storage = allocate(capacity);
+
+            std::memcpy(storage, data_, offset * sizeof(T));
+            std::memcpy(storage + offset, first, count * sizeof(T));
+            std::memcpy(storage + offset + count, data_ + offset, (size_ - offset) * sizeof(T));
+
+            release();
+            data_ = storage;
+            capacity_ = capacity;
+        } else {
+            std::memmove(data_ + offset + count, data_ + offset, (size_ - offset) * sizeof(T));
+            std::memcpy(data_ + offset, first, count * sizeof(T));
+        }
+
+        size_ += count;
+        return data_ + offset;
+    }
+
+    iterator insert(iterator position, size_t count, const T& value) {
+        size_t offset = position - data_;
+        T copy = value;
+
+        grow(size_ + count);
+
+        std::memmove(data_ + offset + count, data_ + offset, (size_ - offset) * sizeof(T));
+        std::fill(data_ + offset, data_ + offset + count, copy);
+
+        size_ += count;
+        return data_ + offset;
+    }
+
+    iterator erase(iterator first, iterator last) {
+        std::memmove(first, last, (end() - last) * sizeof(T));
+        size_ -= last - first;
+
+        return first;
+    }
+
+private:
+    static T* allocate(size_t capacity) {
+        return static_cast<T*>(::operator new(capacity * sizeof(T)));
+    }
+
+    T* inlineData() { return reinterpret_cast<T*>(&inline_); }
+    const T* inlineData() const { return reinterpret_cast<const T*>(&inline_); }
+
+    bool overlaps(const T* first, const T* last) const {
+        std::less<const T*> less;
+        return less(first, data_ + size_) && less(data_, last);
+    }
+
+    // Grows geometrically so repeated appends stay amortized constant time.
+    void grow(size_t required) {
+        if (required > capacity_) {
+            reallocate(std::max(required, capacity_ * 2));
+        }
+    }
+
+    void reallocate(size_t capacity) {
+        T* storage = allocate(capacity);
+        std::memcpy(storage, data_, size_ * sizeof(T));
+
+        release();
+        data_ = storage;
+        capacity_ = capacity;
+    }
+
+    void release() {
+        if (!is_inline()) {
+            ::operator delete(data_);
+        }
+    }
+
+    // Takes the contents of other, which is left empty. Any heap storage of
+    // this vector must already have been released.
+    void steal(SmallVector& other) {
+        if (other.is_inline()) {
+            data_ = inlineData();
+            size_ = other.size_;
+            capacity_ = InlineCapacity;
+            std::memcpy(data_, other.data_, other.size_ * sizeof(T));
+            other.size_ = 0;
+            return;
+        }
+
+        data_ = other.data_;
+        size_ = other.size_;
+        capacity_ = other.capacity_;
+
+        other.data_ = other.inlineData();
+        other.size_ = 0;
+        other.capacity_ = InlineCapacity;
+    }
+
+    T* data_;
+    size_t size_;
+    size_t capacity_;
+    typename std::aligned_storage<sizeof(T) * InlineCapacity, alignof(T)>::type inline_;
+};
+
+template<typename T, size_t InlineCapacity>
+const size_t SmallVector<T, InlineCapacity>::inline_capacity;
+
+}  // namespace anh
+
+#endif  // ANH_SMALL_VECTOR_H_
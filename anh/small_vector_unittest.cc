@@ -0,0 +1,116 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/small_vector.h"
+
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+using anh::SmallVector;
+
+// Wrapping tests in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+typedef SmallVector<uint8_t, 8> SmallBytes;
+
+TEST(SmallVectorTests, StartsEmptyAndInline)
+{
+    SmallBytes bytes;
+
+    EXPECT_TRUE(bytes.empty());
+    EXPECT_TRUE(bytes.is_inline());
+    EXPECT_EQ(size_t(8), bytes.capacity());
+}
+
+TEST(SmallVectorTests, SpillsToHeapWhenInlineCapacityIsExceeded)
+{
+    SmallBytes bytes;
+
+    for (uint8_t i = 0; i < 8; ++i) {
+        bytes.push_back(i);
+    }
+
+    EXPECT_TRUE(bytes.is_inline());
+
+    bytes.push_back(8);
+    EXPECT_FALSE(bytes.is_inline());
+    EXPECT_LE(size_t(9), bytes.capacity());
+
+    for (uint8_t i = 0; i < 9; ++i) {
+        EXPECT_EQ(i, bytes[i]);
+    }
+}
+
+TEST(SmallVectorTests, InsertAndEraseShiftTheTail)
+{
+    const uint8_t initial[] = { 1, 2, 5, 6 };
+    const uint8_t middle[] = { 3, 4 };
+
+    SmallBytes bytes(initial, initial + 4);
+    bytes.insert(bytes.begin() + 2, middle, middle + 2);
+
+    ASSERT_EQ(size_t(6), bytes.size());
+    for (uint8_t i = 0; i < 6; ++i) {
+        EXPECT_EQ(i + 1, bytes[i]);
+    }
+
+    bytes.erase(bytes.begin() + 1, bytes.begin() + 3);
+
+    ASSERT_EQ(size_t(4), bytes.size());
+    EXPECT_EQ(1, bytes[0]);
+    EXPECT_EQ(4, bytes[1]);
+
+    bytes.insert(bytes.begin(), 7, 9);
+    ASSERT_EQ(size_t(11), bytes.size());
+    EXPECT_EQ(9, bytes[6]);
+    EXPECT_EQ(1, bytes[7]);
+}
+
+TEST(SmallVectorTests, CanInsertElementsOfItself)
+{
+    const uint8_t initial[] = { 1, 2, 3, 4, 5, 6 };
+
+    SmallBytes bytes(initial, initial + 6);
+    bytes.insert(bytes.end(), bytes.begin(), bytes.begin() + 4);
+
+    ASSERT_EQ(size_t(10), bytes.size());
+    EXPECT_EQ(1, bytes[6]);
+    EXPECT_EQ(4, bytes[9]);
+}
+
+TEST(SmallVectorTests, MoveTakesHeapStorage)
+{
+    SmallBytes bytes(32);
+    const uint8_t* storage = bytes.data();
+
+    SmallBytes moved(std::move(bytes));
+
+    EXPECT_EQ(storage, moved.data());
+    EXPECT_EQ(size_t(32), moved.size());
+    EXPECT_TRUE(bytes.empty());
+    EXPECT_TRUE(bytes.is_inline());
+}
+
+TEST(SmallVectorTests, SwapMixesInlineAndHeapStorage)
+{
+    SmallBytes small(2);
+    small[0] = 1;
+    small[1] = 2;
+
+    SmallBytes large(20);
+    large[19] = 3;
+
+    small.swap(large);
+
+    ASSERT_EQ(size_t(20), small.size());
+    EXPECT_EQ(3, small[19]);
+    EXPECT_FALSE(small.is_inline());
+
+    ASSERT_EQ(size_t(2), large.size());
+    EXPECT_EQ(2, large[1]);
+    EXPECT_TRUE(large.is_inline());
+}
+
+}  // namespace
@@ -0,0 +1,154 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/string_dictionary.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "anh/memcrc.h"
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+namespace {
+
+const uint64_t kLiteralTag = 0;
+const uint64_t kNewEntryTag = 1;
+const uint64_t kFirstSlotTag = 2;
+
+// Strings are written with a 16 bit length, so no longer ones can be kept.
+size_t clampMaxLength(size_t max_length) {
+    return std::min<size_t>(max_length, 0xFFFF);
+}
+
+}  // namespace
+
+StringDictionaryEncoder::StringDictionaryEncoder(size_t max_entries, size_t max_length)
+    : max_entries_(max_entries)
+    , max_length_(clampMaxLength(max_length))
+    , next_slot_(0) {}
+
+void StringDictionaryEncoder::write(ByteBuffer& buffer, const std::string& data) {
+    if (data.length() > max_length_ || max_entries_ == 0) {
+        buffer.writeVarint<uint64_t>(kLiteralTag);
+        buffer.write<std::string>(data);
+        return;
+    }
+
+    uint32_t ident = memcrc(data);
+
+    auto found = slots_.find(ident);
+    if (found != slots_.end()) {
+        // Only a matching string may be referred to, one that merely shares
+        // its ident is sent in full instead.
+        if (entries_[found->second].data == data) {
+            buffer.writeVarint<uint64_t>(kFirstSlotTag + found->second);
+        } else {
+            buffer.writeVarint<uint64_t>(kLiteralTag);
+            buffer.write<std::string>(data);
+        }
+
+        return;
+    }
+
+    size_t slot = next_slot_;
+    next_slot_ = (next_slot_ + 1) % max_entries_;
+
+    if (slot < entries_.size()) {
+        slots_.erase(entries_[slot].ident);
+        entries_[slot].ident = ident;
+        entries_[slot].data = data;
+    } else {
+        Entry entry = { ident, data };
+        entries_.push_back(entry);
+    }
+
+    slots_[ident] = slot;
+
+    buffer.writeVarint<uint64_t>(kNewEntryTag);
+    buffer.write<uint32_t>(ident);
+    buffer.write<std::string>(data);
+}
+
+void StringDictionaryEncoder::reset() {
+    entries_.clear();
+    slots_.clear();
+    next_slot_ = 0;
+}
+
+size_t StringDictionaryEncoder::size() const {
+    return entries_.size();
+}
+
+size_t StringDictionaryEncoder::max_entries() const {
+    return max_entries_;
+}
+
+size_t StringDictionaryEncoder::max_length() const {
+    return max_length_;
+}
+
+StringDictionaryDecoder::StringDictionaryDecoder(size_t max_entries, size_t max_length)
+    : max_entries_(max_entries)
+    , max_length_(clampMaxLength(max_length))
+    , next_slot_(0) {}
+
+void StringDictionaryDecoder::read(ByteBuffer& buffer, std::string& data) {
+    uint64_t tag = buffer.readVarint<uint64_t>();
+
+    if (tag == kLiteralTag) {
+        buffer.readString(data);
+        return;
+    }
+
+    if (tag >= kFirstSlotTag) {
+        if (tag - kFirstSlotTag >= entries_.size()) {
+            throw std::runtime_error("Unknown string dictionary entry");
+        }
+
+        data = entries_[static_cast<size_t>(tag - kFirstSlotTag)];
+        return;
+    }
+
+    uint32_t ident = buffer.read<uint32_t>();
+    StringView view = buffer.readStringView();
+
+    if (view.length() > max_length_ || max_entries_ == 0) {
+        throw std::runtime_error("String dictionary limits do not match");
+    }
+
+    if (memcrc(view.data(), view.length()) != ident) {
+        throw std::runtime_error("String dictionary ident does not match");
+    }
+
+    size_t slot = next_slot_;
+    next_slot_ = (next_slot_ + 1) % max_entries_;
+
+    if (slot < entries_.size()) {
+        entries_[slot].assign(view.data(), view.length());
+    } else {
+        entries_.push_back(view.str());
+    }
+
+    data = entries_[slot];
+}
+
+std::string StringDictionaryDecoder::read(ByteBuffer& buffer) {
+    std::string data;
+    read(buffer, data);
+    return data;
+}
+
+void StringDictionaryDecoder::reset() {
+    entries_.clear();
+    next_slot_ = 0;
+}
+
+size_t StringDictionaryDecoder::size() const {
+    return entries_.size();
+}
+
+}  // namespace anh
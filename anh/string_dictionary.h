@@ -0,0 +1,135 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#ifndef ANH_STRING_DICTIONARY_H_
+#define ANH_STRING_DICTIONARY_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "anh/byte_buffer.h"
+
+/// The anh namespace hosts a number of useful utility classes intended
+/// to be used and reused in domain specific classes.
+namespace anh {
+
+/*! \brief Writes strings that repeat over a connection, such as names and
+ * template paths, once and refers back to them afterwards.
+ *
+ * Each string is prefixed by a varint tag:
+ *
+ *  - 0: the string follows as written by write<std::string> and is not kept.
+ *  - 1: the HashString ident of the string and the string follow, and both
+ *       sides store it in the next slot of their table.
+ *  - n >= 2: the string stored in slot n - 2.
+ *
+ * Slots are reused oldest first once the table holds max_entries strings,
+ * and strings longer than max_length are never stored. Both sides must be
+ * created with the same limits and see every string in the same order, so
+ * use one encoder and one decoder per connection and direction.
+ *
+ * \code
+ * anh::StringDictionaryEncoder encoder;
+ * encoder.write(buffer, "object/creature/player/shared_human_male.iff");
+ *
+ * anh::StringDictionaryDecoder decoder;
+ * std::string path = decoder.read(buffer);
+ * \endcode
+ */
+class StringDictionaryEncoder {
+public:
+    enum { DEFAULT_MAX_ENTRIES = 1024 };
+    enum { DEFAULT_MAX_LENGTH = 256 };
+
+    /**
+     * \param max_entries The number of strings kept before the oldest is reused.
+     * \param max_length The longest string that is kept, at most 65535 bytes.
+     */
+    explicit StringDictionaryEncoder(size_t max_entries = DEFAULT_MAX_ENTRIES,
+        size_t max_length = DEFAULT_MAX_LENGTH);
+
+    /**
+     * Writes a string, or a reference to it if it was written before.
+     *
+     * \param buffer The buffer to write to.
+     * \param data The string to write.
+     */
+    void write(ByteBuffer& buffer, const std::string& data);
+
+    /// Forgets every string, for when the connection starts over.
+    void reset();
+
+    /// \returns The number of strings the table holds.
+    size_t size() const;
+
+    size_t max_entries() const;
+    size_t max_length() const;
+
+private:
+    /// Disable copying, the copy would fall out of step with the decoder.
+    StringDictionaryEncoder(const StringDictionaryEncoder&);
+    StringDictionaryEncoder& operator=(const StringDictionaryEncoder&);
+
+    struct Entry {
+        uint32_t ident;
+        std::string data;
+    };
+
+    size_t max_entries_;
+    size_t max_length_;
+    size_t next_slot_;
+
+    std::vector<Entry> entries_;
+    std::unordered_map<uint32_t, size_t> slots_;
+};
+
+/*! \brief Reads strings written by a StringDictionaryEncoder, keeping a
+ * mirror of its table.
+ */
+class StringDictionaryDecoder {
+public:
+    /**
+     * \param max_entries Must match the encoder.
+     * \param max_length Must match the encoder.
+     */
+    explicit StringDictionaryDecoder(
+        size_t max_entries = StringDictionaryEncoder::DEFAULT_MAX_ENTRIES,
+        size_t max_length = StringDictionaryEncoder::DEFAULT_MAX_LENGTH);
+
+    /**
+     * Reads a string written by StringDictionaryEncoder::write.
+     *
+     * \param buffer The buffer to read from, starting at its read position.
+     * \param data The string to replace with the one read.
+     * \throws std::out_of_range If the string runs past the end of the buffer.
+     * \throws std::runtime_error If the buffer does not match the table.
+     */
+    void read(ByteBuffer& buffer, std::string& data);
+
+    /// \returns The string read from buffer.
+    std::string read(ByteBuffer& buffer);
+
+    /// Forgets every string, for when the connection starts over.
+    void reset();
+
+    /// \returns The number of strings the table holds.
+    size_t size() const;
+
+private:
+    /// Disable copying, the copy would fall out of step with the encoder.
+    StringDictionaryDecoder(const StringDictionaryDecoder&);
+    StringDictionaryDecoder& operator=(const StringDictionaryDecoder&);
+
+    size_t max_entries_;
+    size_t max_length_;
+    size_t next_slot_;
+
+    std::vector<std::string> entries_;
+};
+
+}  // namespace anh
+
+#endif  // ANH_STRING_DICTIONARY_H_
@@ -0,0 +1,121 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/string_dictionary.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+using anh::ByteBuffer;
+using anh::StringDictionaryDecoder;
+using anh::StringDictionaryEncoder;
+
+// Wrapping benchmarks in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+const size_t kCorpusSize = 10000;
+
+// The strings a zone sends a client: a few thousand distinct template paths
+// and names, with the popular ones far more common than the rest.
+std::vector<std::string> makeCorpus() {
+    const char* species[] = { "human", "rodian", "trandoshan", "twilek", "wookiee", "zabrak" };
+    const char* kinds[] = { "creature/npc", "creature/player", "tangible/furniture", "building/player", "weapon/ranged" };
+
+    std::vector<std::string> distinct;
+    for (size_t i = 0; i < 2000; ++i) {
+        if (i % 3 == 0) {
+            distinct.push_back("Citizen " + std::to_string(i));
+        } else {
+            distinct.push_back(std::string("object/") + kinds[i % 5] + "/shared_" + species[i % 6] +
+                "_" + std::to_string(i) + ".iff");
+        }
+    }
+
+    std::mt19937 random(42);
+    std::vector<double> weights;
+    for (size_t i = 0; i < distinct.size(); ++i) {
+        weights.push_back(1.0 / (i + 1));
+    }
+    std::discrete_distribution<size_t> zipf(weights.begin(), weights.end());
+
+    std::vector<std::string> corpus;
+    for (size_t i = 0; i < kCorpusSize; ++i) {
+        corpus.push_back(distinct[zipf(random)]);
+    }
+
+    return corpus;
+}
+
+const std::vector<std::string>& corpus() {
+    static const std::vector<std::string> corpus = makeCorpus();
+    return corpus;
+}
+
+void BM_WritePlainStrings(benchmark::State& state) {
+    const std::vector<std::string>& strings = corpus();
+
+    ByteBuffer buffer;
+    for (auto _ : state) {
+        buffer.clear();
+        for (size_t i = 0; i < strings.size(); ++i) {
+            buffer.write<std::string>(strings[i]);
+        }
+        benchmark::DoNotOptimize(buffer.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * strings.size());
+    state.counters["wire_bytes"] = static_cast<double>(buffer.size());
+}
+BENCHMARK(BM_WritePlainStrings);
+
+void BM_WriteDictionaryStrings(benchmark::State& state) {
+    const std::vector<std::string>& strings = corpus();
+    size_t plain_size = 0;
+    for (size_t i = 0; i < strings.size(); ++i) {
+        plain_size += 2 + strings[i].length();
+    }
+
+    ByteBuffer buffer;
+    for (auto _ : state) {
+        StringDictionaryEncoder encoder(static_cast<size_t>(state.range(0)));
+        buffer.clear();
+        for (size_t i = 0; i < strings.size(); ++i) {
+            encoder.write(buffer, strings[i]);
+        }
+        benchmark::DoNotOptimize(buffer.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * strings.size());
+    state.counters["wire_bytes"] = static_cast<double>(buffer.size());
+    state.counters["saved_percent"] = 100.0 * (1.0 - static_cast<double>(buffer.size()) / plain_size);
+}
+BENCHMARK(BM_WriteDictionaryStrings)->Arg(64)->Arg(256)->Arg(1024)->Arg(4096);
+
+void BM_ReadDictionaryStrings(benchmark::State& state) {
+    const std::vector<std::string>& strings = corpus();
+
+    StringDictionaryEncoder encoder(static_cast<size_t>(state.range(0)));
+    ByteBuffer buffer;
+    for (size_t i = 0; i < strings.size(); ++i) {
+        encoder.write(buffer, strings[i]);
+    }
+
+    std::string data;
+    for (auto _ : state) {
+        StringDictionaryDecoder decoder(static_cast<size_t>(state.range(0)));
+        buffer.readPosition(0);
+        for (size_t i = 0; i < strings.size(); ++i) {
+            decoder.read(buffer, data);
+        }
+        benchmark::DoNotOptimize(data.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * strings.size());
+}
+BENCHMARK(BM_ReadDictionaryStrings)->Arg(256)->Arg(1024);
+
+}  // namespace
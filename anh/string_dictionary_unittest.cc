@@ -0,0 +1,166 @@
+// Copyright (c) 2010 ANH Studios. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the COPYING file.
+
+#include "anh/string_dictionary.h"
+
+#include <gtest/gtest.h>
+
+#include "anh/memcrc.h"
+
+using anh::ByteBuffer;
+using anh::StringDictionaryDecoder;
+using anh::StringDictionaryEncoder;
+
+// Wrapping tests in an anonymous namespace prevents potential name conflicts.
+namespace {
+
+const std::string kTemplate = "object/creature/player/shared_human_male.iff";
+
+TEST(StringDictionaryTests, RepeatedStringIsSentOnce)
+{
+    StringDictionaryEncoder encoder;
+    ByteBuffer buffer;
+
+    encoder.write(buffer, kTemplate);
+    size_t first = buffer.size();
+
+    // Tag, ident and the string as write<std::string> would send it.
+    EXPECT_EQ(1 + 4 + 2 + kTemplate.length(), first);
+
+    encoder.write(buffer, kTemplate);
+    EXPECT_EQ(1u, buffer.size() - first);
+
+    StringDictionaryDecoder decoder;
+    EXPECT_EQ(kTemplate, decoder.read(buffer));
+    EXPECT_EQ(kTemplate, decoder.read(buffer));
+    EXPECT_EQ(1u, decoder.size());
+}
+
+TEST(StringDictionaryTests, NewEntryCarriesHashStringIdent)
+{
+    StringDictionaryEncoder encoder;
+    ByteBuffer buffer;
+
+    encoder.write(buffer, kTemplate);
+
+    EXPECT_EQ(1u, buffer.read<uint8_t>());
+    EXPECT_EQ(anh::memcrc(kTemplate), buffer.read<uint32_t>());
+    EXPECT_EQ(kTemplate, buffer.read<std::string>());
+}
+
+TEST(StringDictionaryTests, CanRoundTripInterleavedStrings)
+{
+    const char* strings[] = { "Han Solo", "Chewbacca", "", "Han Solo", "Lando", "Chewbacca", "" };
+
+    StringDictionaryEncoder encoder;
+    ByteBuffer buffer;
+
+    for (size_t i = 0; i < sizeof(strings) / sizeof(strings[0]); ++i) {
+        encoder.write(buffer, strings[i]);
+    }
+
+    StringDictionaryDecoder decoder;
+    std::string data;
+
+    for (size_t i = 0; i < sizeof(strings) / sizeof(strings[0]); ++i) {
+        decoder.read(buffer, data);
+        EXPECT_EQ(strings[i], data);
+    }
+
+    EXPECT_EQ(encoder.size(), decoder.size());
+}
+
+TEST(StringDictionaryTests, OldestEntryIsEvictedFirst)
+{
+    StringDictionaryEncoder encoder(2);
+    StringDictionaryDecoder decoder(2);
+    ByteBuffer buffer;
+
+    encoder.write(buffer, "first");
+    encoder.write(buffer, "second");
+    encoder.write(buffer, "third");
+    EXPECT_EQ(2u, encoder.size());
+
+    // "first" was evicted so it is sent in full again, evicting "second".
+    size_t before = buffer.size();
+    encoder.write(buffer, "first");
+    EXPECT_GT(buffer.size() - before, 1u);
+
+    before = buffer.size();
+    encoder.write(buffer, "third");
+    EXPECT_EQ(1u, buffer.size() - before);
+
+    const char* expected[] = { "first", "second", "third", "first", "third" };
+    for (size_t i = 0; i < 5; ++i) {
+        EXPECT_EQ(expected[i], decoder.read(buffer));
+    }
+
+    EXPECT_EQ(0u, buffer.size() - buffer.readPosition());
+}
+
+TEST(StringDictionaryTests, LongStringsAreNotKept)
+{
+    StringDictionaryEncoder encoder(16, 8);
+    StringDictionaryDecoder decoder(16, 8);
+    ByteBuffer buffer;
+
+    std::string long_string(9, 'x');
+
+    encoder.write(buffer, long_string);
+    encoder.write(buffer, long_string);
+    EXPECT_EQ(2 * (1 + 2 + long_string.length()), buffer.size());
+    EXPECT_EQ(0u, encoder.size());
+
+    EXPECT_EQ(long_string, decoder.read(buffer));
+    EXPECT_EQ(long_string, decoder.read(buffer));
+    EXPECT_EQ(0u, decoder.size());
+}
+
+TEST(StringDictionaryTests, ResetForgetsEntries)
+{
+    StringDictionaryEncoder encoder;
+    ByteBuffer buffer;
+
+    encoder.write(buffer, kTemplate);
+    encoder.reset();
+    EXPECT_EQ(0u, encoder.size());
+
+    buffer.clear();
+    encoder.write(buffer, kTemplate);
+    EXPECT_EQ(1u, buffer.read<uint8_t>());
+}
+
+TEST(StringDictionaryTests, UnknownEntryThrowsException)
+{
+    ByteBuffer buffer;
+    buffer.writeVarint<uint64_t>(2);
+
+    StringDictionaryDecoder decoder;
+    EXPECT_THROW(decoder.read(buffer), std::runtime_error);
+}
+
+TEST(StringDictionaryTests, MismatchedIdentThrowsException)
+{
+    ByteBuffer buffer;
+    buffer.writeVarint<uint64_t>(1);
+    buffer.write<uint32_t>(anh::memcrc(kTemplate) ^ 1);
+    buffer.write<std::string>(kTemplate);
+
+    StringDictionaryDecoder decoder;
+    EXPECT_THROW(decoder.read(buffer), std::runtime_error);
+}
+
+TEST(StringDictionaryTests, TruncatedStringThrowsException)
+{
+    StringDictionaryEncoder encoder;
+    ByteBuffer buffer;
+    encoder.write(buffer, kTemplate);
+
+    ByteBuffer truncated(buffer.data(), buffer.size() - 1);
+
+    StringDictionaryDecoder decoder;
+    EXPECT_THROW(decoder.read(truncated), std::out_of_range);
+}
+
+}  // namespace
@@ -143,22 +143,22 @@ rem ----------------------------------------------------------------------------
 rem --- Start of BUILD_ENVIRONMENT ---------------------------------------------
 :BUILD_ENVIRONMENT
 
-if not exist "%VS100COMNTOOLS%" (
-  set "VS100COMNTOOLS=%PROGRAMFILES(X86)%\Microsoft Visual Studio 10.0\Common7\Tools"
-  if not exist "!VS100COMNTOOLS!" (
-  	  set "VS100COMNTOOLS=%PROGRAMFILES%\Microsoft Visual Studio 10.0\Common7\Tools"
-  	  if not exist "!VS100COMNTOOLS!" (          
+if not exist "%VS140COMNTOOLS%" (
+  set "VS140COMNTOOLS=%PROGRAMFILES(X86)%\Microsoft Visual Studio 14.0\Common7\Tools"
+  if not exist "!VS140COMNTOOLS!" (
+  	  set "VS140COMNTOOLS=%PROGRAMFILES%\Microsoft Visual Studio 14.0\Common7\Tools"
+  	  if not exist "!VS140COMNTOOLS!" (          
   		    rem TODO: Allow user to enter a path to their base visual Studio directory.
          
-    	    echo ***** Microsoft Visual Studio 10.0 required *****
+    	    echo ***** Microsoft Visual Studio 14.0 required *****
     	    exit /b 1
   	  )
   )
 )
 
-set "MSBUILD=%WINDIR%\Microsoft.NET\Framework\v4.0.30319\msbuild.exe"
+set "MSBUILD=%PROGRAMFILES(X86)%\MSBuild\14.0\Bin\msbuild.exe"
 
-call "%VS100COMNTOOLS%\vsvars32.bat" >NUL
+call "%VS140COMNTOOLS%\vsvars32.bat" >NUL
 
 set environment_built=yes
 
@@ -290,15 +290,15 @@ if not exist "tools\jam\src\bin.ntx86\bjam.exe" (
 rem Build the boost libraries we need.
 
 if "%BUILD_TYPE%" == "debug" (
-	cmd /c "tools\jam\src\bin.ntx86\bjam.exe" --toolset=msvc-10.0 --with-date_time --with-thread variant=debug link=static runtime-link=shared threading=multi define=_SCL_SECURE_NO_WARNINGS=0
+	cmd /c "tools\jam\src\bin.ntx86\bjam.exe" --toolset=msvc-14.0 --with-date_time --with-thread variant=debug link=static runtime-link=shared threading=multi define=_SCL_SECURE_NO_WARNINGS=0
 )
 
 if "%BUILD_TYPE%" == "release" (
-	cmd /c "tools\jam\src\bin.ntx86\bjam.exe" --toolset=msvc-10.0 --with-date_time --with-thread variant=release link=static runtime-link=shared threading=multi define=_SCL_SECURE_NO_WARNINGS=0
+	cmd /c "tools\jam\src\bin.ntx86\bjam.exe" --toolset=msvc-14.0 --with-date_time --with-thread variant=release link=static runtime-link=shared threading=multi define=_SCL_SECURE_NO_WARNINGS=0
 )
 
 if "%BUILD_TYPE%" == "all" (
-	cmd /c "tools\jam\src\bin.ntx86\bjam.exe" --toolset=msvc-10.0 --with-date_time --with-thread variant=debug,release link=static runtime-link=shared threading=multi define=_SCL_SECURE_NO_WARNINGS=0
+	cmd /c "tools\jam\src\bin.ntx86\bjam.exe" --toolset=msvc-14.0 --with-date_time --with-thread variant=debug,release link=static runtime-link=shared threading=multi define=_SCL_SECURE_NO_WARNINGS=0
 )
 
 cd "%PROJECT_BASE%"
@@ -349,20 +349,20 @@ if "%BUILD_TYPE%" == "all" (
 if exist "*.cache" del /S /Q "*.cache" >NUL
 
 if "%BUILD_TYPE%" == "debug" (
-	"%MSBUILD%" "gtest-md.sln" /t:build /p:Platform=Win32,Configuration=Debug,VCBuildAdditionalOptions="/useenv"
+	"%MSBUILD%" "gtest-md.sln" /t:build /p:PlatformToolset=v140,Platform=Win32,Configuration=Debug,VCBuildAdditionalOptions="/useenv"
 	if exist "*.cache" del /S /Q "*.cache" >NUL
 )
 
 if "%BUILD_TYPE%" == "release" (
-	"%MSBUILD%" "gtest-md.sln" /t:build /p:Platform=Win32,Configuration=Release,VCBuildAdditionalOptions="/useenv"
+	"%MSBUILD%" "gtest-md.sln" /t:build /p:PlatformToolset=v140,Platform=Win32,Configuration=Release,VCBuildAdditionalOptions="/useenv"
 	if exist "*.cache" del /S /Q "*.cache" >NUL
 )
 
 if "%BUILD_TYPE%" == "all" (
-	"%MSBUILD%" "gtest-md.sln" /t:build /p:Platform=Win32,Configuration=Debug,VCBuildAdditionalOptions="/useenv"
+	"%MSBUILD%" "gtest-md.sln" /t:build /p:PlatformToolset=v140,Platform=Win32,Configuration=Debug,VCBuildAdditionalOptions="/useenv"
 	if exist "*.cache" del /S /Q "*.cache" >NUL
 
-	"%MSBUILD%" "gtest-md.sln" /t:build /p:Platform=Win32,Configuration=Release,VCBuildAdditionalOptions="/useenv"
+	"%MSBUILD%" "gtest-md.sln" /t:build /p:PlatformToolset=v140,Platform=Win32,Configuration=Release,VCBuildAdditionalOptions="/useenv"
 	if exist "*.cache" del /S /Q "*.cache" >NUL
 )
 
@@ -414,20 +414,20 @@ if "%BUILD_TYPE%" == "all" (
 if exist "*.cache" del /S /Q "*.cache" >NUL
 
 if "%BUILD_TYPE%" == "debug" (
-	"%MSBUILD%" "google-glog.sln" /t:build /p:Platform=Win32,Configuration=Debug,VCBuildAdditionalOptions="/useenv"
+	"%MSBUILD%" "google-glog.sln" /t:build /p:PlatformToolset=v140,Platform=Win32,Configuration=Debug,VCBuildAdditionalOptions="/useenv"
 	if exist "*.cache" del /S /Q "*.cache" >NUL
 )
 
 if "%BUILD_TYPE%" == "release" (
-	"%MSBUILD%" "google-glog.sln" /t:build /p:Platform=Win32,Configuration=Release,VCBuildAdditionalOptions="/useenv"
+	"%MSBUILD%" "google-glog.sln" /t:build /p:PlatformToolset=v140,Platform=Win32,Configuration=Release,VCBuildAdditionalOptions="/useenv"
 	if exist "*.cache" del /S /Q "*.cache" >NUL
 )
 
 if "%BUILD_TYPE%" == "all" (
-	"%MSBUILD%" "google-glog.sln" /t:build /p:Platform=Win32,Configuration=Debug,VCBuildAdditionalOptions="/useenv"
+	"%MSBUILD%" "google-glog.sln" /t:build /p:PlatformToolset=v140,Platform=Win32,Configuration=Debug,VCBuildAdditionalOptions="/useenv"
 	if exist "*.cache" del /S /Q "*.cache" >NUL
 
-	"%MSBUILD%" "google-glog.sln" /t:build /p:Platform=Win32,Configuration=Release,VCBuildAdditionalOptions="/useenv"
+	"%MSBUILD%" "google-glog.sln" /t:build /p:PlatformToolset=v140,Platform=Win32,Configuration=Release,VCBuildAdditionalOptions="/useenv"
 	if exist "*.cache" del /S /Q "*.cache" >NUL
 )
 